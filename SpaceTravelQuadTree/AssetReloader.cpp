@@ -0,0 +1,155 @@
+#include <ctime>
+#include <iostream>
+#include <vector>
+
+#include "AssetReloader.h"
+#include "FileWatcher.h"
+#include "Renderer.h"
+#include "ShaderManager.h"
+
+AssetReloader::~AssetReloader()
+{
+	stop();
+}
+
+void AssetReloader::start(GLFWwindow* window, const char* vShaderFile, const char* fShaderFile, const char* configFile)
+{
+	this->vShaderFile = vShaderFile;
+	this->fShaderFile = fShaderFile;
+	this->configFile = configFile;
+
+	// GLFW windows must be created on the main thread, only their contexts may move.
+	glfwWindowHint(GLFW_VISIBLE, GL_FALSE);
+	context = glfwCreateWindow(1, 1, "", nullptr, window);
+	glfwDefaultWindowHints();
+	if (!context)
+	{
+		cerr << "Failed to create a context to reload shaders on, assets will not be reloaded" << endl;
+		return;
+	}
+
+	running = true;
+	worker = thread(&AssetReloader::run, this);
+}
+
+void AssetReloader::stop()
+{
+	if (!running) return;
+	running = false;
+	worker.join();
+
+	glfwDestroyWindow(context);
+	context = nullptr;
+	if (pendingProgram) glDeleteProgram(pendingProgram);
+	pendingProgram = 0;
+	delete pendingField;
+	pendingField = nullptr;
+	freeRetiredField();
+}
+
+bool AssetReloader::apply()
+{
+	// Never wait for the background thread, whatever it hands over is picked up next frame.
+	unique_lock<mutex> lock(pendingMutex, try_to_lock);
+	if (!lock.owns_lock()) return false;
+
+	bool applied = false;
+	if (pendingProgram)
+	{
+		Renderer::getInstance().setShaderProgram(pendingProgram);
+		pendingProgram = 0;
+		applied = true;
+	}
+
+	// Freeing a whole field takes a while, so the old one goes back to the background thread.
+	if (pendingField && !retiredField)
+	{
+		AsteroidField::getInstance().swap(*pendingField);
+		retiredField = pendingField;
+		pendingField = nullptr;
+		applied = true;
+	}
+	return applied;
+}
+
+void AssetReloader::run()
+{
+	glfwMakeContextCurrent(context);
+
+	FileWatcher watcher;
+	watcher.watch(vShaderFile);
+	watcher.watch(fShaderFile);
+	watcher.watch(configFile);
+
+	while (running)
+	{
+		vector<string> changed;
+		watcher.waitForChanges(ASSET_RELOADER_POLL_MS, changed);
+		freeRetiredField();
+
+		bool shadersChanged = false, configChanged = false;
+		for (const string& path : changed)
+		{
+			if (path == configFile) configChanged = true;
+			else shadersChanged = true;
+		}
+		if (shadersChanged) reloadShaders();
+		if (configChanged) reloadField();
+	}
+
+	glfwMakeContextCurrent(nullptr);
+}
+
+void AssetReloader::reloadShaders()
+{
+	GLuint program = ShaderManager::getInstance().tryLoad(vShaderFile.c_str(), fShaderFile.c_str());
+	if (program == 0)
+	{
+		cerr << "Keeping the current shaders" << endl;
+		return;
+	}
+
+	// The program must be complete before another context uses it.
+	glFinish();
+
+	lock_guard<mutex> lock(pendingMutex);
+	if (pendingProgram) glDeleteProgram(pendingProgram); // Superseded before it was applied.
+	pendingProgram = program;
+	cout << "Reloaded " << vShaderFile << " and " << fShaderFile << endl;
+}
+
+void AssetReloader::reloadField()
+{
+	FieldConfig config;
+	if (!AsteroidField::loadConfig(configFile.c_str(), config))
+	{
+		cerr << "Keeping the current asteroid field" << endl;
+		return;
+	}
+
+	// This thread does not share the main thread's random sequence on every platform, so a field
+	// meant to differ each run gets its seed explicitly, as at startup.
+	if (config.seed == 0) config.seed = (unsigned int)time(0);
+	AsteroidField* field = new AsteroidField();
+	field->generate(config);
+
+	AsteroidField* superseded;
+	{
+		lock_guard<mutex> lock(pendingMutex);
+		superseded = pendingField;
+		pendingField = field;
+	}
+	delete superseded;
+	cout << "Regenerated the asteroid field from " << configFile << endl;
+}
+
+void AssetReloader::freeRetiredField()
+{
+	AsteroidField* field;
+	{
+		lock_guard<mutex> lock(pendingMutex);
+		field = retiredField;
+		retiredField = nullptr;
+	}
+	delete field;
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <GL/glfw3.h>
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "AsteroidField.h"
+
+using namespace std;
+
+#define ASSET_RELOADER_POLL_MS 100 // Longest the background thread sleeps before checking for stop().
+
+// Reloads the shaders and the field config while the game runs, whenever their files are saved.
+// The work is done on a background thread: shaders are compiled on the context of a hidden
+// window that shares objects with the game's, and a changed config is generated into a field of
+// its own. apply() swaps finished results in between frames without ever waiting for them, so an
+// edit does not cause a hitch. Shaders that fail to build and configs that fail to parse are
+// reported and leave the running assets as they are.
+class AssetReloader
+{
+public:
+	// Start watching. Must be called on the thread that created window, after the assets have
+	// been loaded once.
+	void start(GLFWwindow* window, const char* vShaderFile, const char* fShaderFile, const char* configFile);
+	void stop();
+
+	// Swap in the assets reloaded since the last call. Call between frames. Returns whether
+	// anything was swapped in.
+	bool apply();
+
+	~AssetReloader();
+	static AssetReloader& getInstance() {
+		static AssetReloader instance;
+		return instance;
+	}
+
+private:
+	GLFWwindow* context = nullptr; // Hidden window whose context the background thread compiles on.
+	string vShaderFile, fShaderFile, configFile;
+	thread worker;
+	atomic<bool> running{ false };
+
+	// Hand-over between the threads.
+	mutex pendingMutex;
+	GLuint pendingProgram = 0; // Linked, waiting to be drawn with.
+	AsteroidField* pendingField = nullptr; // Generated, waiting to be swapped in.
+	AsteroidField* retiredField = nullptr; // Swapped out, waiting to be freed off the main thread.
+
+	void run();
+	void reloadShaders();
+	void reloadField();
+	void freeRetiredField();
+
+	AssetReloader() {}
+	AssetReloader(AssetReloader const&);
+	void operator=(AssetReloader const&);
+};
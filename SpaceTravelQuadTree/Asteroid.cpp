@@ -1,5 +1,4 @@
 #include "Asteroid.h"
-#include "Renderer.h"
 
 using namespace std;
 
@@ -10,6 +9,8 @@ Asteroid::Asteroid()
    centerY = 0.0;
    centerZ = 0.0; 
    radius = 0.0; // Indicates no asteroid exists in the position.
+   velocityX = velocityY = velocityZ = 0.0;
+   spin = spinRate = 0.0;
    color[0] = 0;
    color[1] = 0;
    color[2] = 0;
@@ -23,16 +24,20 @@ Asteroid::Asteroid(float x, float y, float z, float r, unsigned char valueR,
    centerY = y;
    centerZ = z; 
    radius = r;
+   velocityX = velocityY = velocityZ = 0.0;
+   spin = spinRate = 0.0;
    color[0] = valueR;
    color[1] = valueG;
    color[2] = valueB;
 }
 
-// Function to draw asteroid.
-void Asteroid::draw()
+// Function to advance asteroid along its velocity and spin by dt steps.
+void Asteroid::move(float dt)
 {
-   if (radius > 0.0) // If asteroid exists.
-   {
-	   Renderer::getInstance().drawSphere(centerX, centerY, centerZ, color);
-   }
+   centerX += velocityX * dt;
+   centerY += velocityY * dt;
+   centerZ += velocityZ * dt;
+   spin += spinRate * dt;
+   if (spin > 360.0) spin -= 360.0;
+   if (spin < 0.0) spin += 360.0;
 }
@@ -11,8 +11,19 @@ public:
    float getCenterY() { return centerY; }
    float getCenterZ() { return centerZ; }
    float getRadius()  { return radius; }
-   void draw();
+   float getVelocityX() { return velocityX; }
+   float getVelocityY() { return velocityY; }
+   float getVelocityZ() { return velocityZ; }
+   float getSpin() { return spin; }
+   const unsigned char* getColor() { return color; }
+   bool isMoving() { return velocityX != 0 || velocityY != 0 || velocityZ != 0 || spinRate != 0; }
+   void setCenter(float x, float y, float z) { centerX = x; centerY = y; centerZ = z; }
+   void setVelocity(float vx, float vy, float vz) { velocityX = vx; velocityY = vy; velocityZ = vz; }
+   void setSpinRate(float degreesPerStep) { spinRate = degreesPerStep; }
+   void move(float dt);
 private:
    float centerX, centerY, centerZ, radius;
+   float velocityX, velocityY, velocityZ; // Units per step.
+   float spin, spinRate; // Degrees around the y-axis, and degrees per step.
    unsigned char color[3];
 };
@@ -0,0 +1,486 @@
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <emmintrin.h>
+#include <future>
+#include <limits>
+#include <glm/glm.hpp>
+#include <glm/gtx/intersect.hpp>
+
+#include "AsteroidBVH.h"
+
+static_assert(BVH_MAX_DEPTH < BVH_STACK_SIZE, "traversals cannot overflow their stack");
+
+struct AsteroidBVH::BuildNode
+{
+	float min[3], max[3];
+	BuildNode* children[2];
+	int begin, count; // Range of the build order covered by a leaf.
+};
+
+// Bounds of one SAH bin.
+struct Bin
+{
+	float min[3], max[3];
+	int count;
+
+	void reset()
+	{
+		min[0] = min[1] = min[2] = FLT_MAX;
+		max[0] = max[1] = max[2] = -FLT_MAX;
+		count = 0;
+	}
+
+	void grow(const Bin& other)
+	{
+		for (int a = 0; a < 3; a++)
+		{
+			min[a] = std::min(min[a], other.min[a]);
+			max[a] = std::max(max[a], other.max[a]);
+		}
+		count += other.count;
+	}
+
+	float halfArea()
+	{
+		float ex = max[0] - min[0], ey = max[1] - min[1], ez = max[2] - min[2];
+		return count ? ex * ey + ey * ez + ez * ex : 0;
+	}
+};
+
+void AsteroidBVH::build(const int* objectIds, const float* cx, const float* cy, const float* cz, const float* cr, int n)
+{
+	ids.assign(objectIds, objectIds + n);
+	x.assign(cx, cx + n);
+	y.assign(cy, cy + n);
+	z.assign(cz, cz + n);
+	r.assign(cr, cr + n);
+
+	// buildOrder starts as the identity and is partitioned in place into leaf order.
+	buildOrder.resize(n);
+	for (int i = 0; i < n; i++)
+		buildOrder[i] = i;
+
+	nodes.clear();
+	if (n == 0) return;
+
+	BuildNode* root = buildRange(0, n, 0);
+	flatten(root);
+
+	// Store the spheres in leaf order, and remember where each one went for refit().
+	vector<int> leafIds(n), leafOf(n);
+	vector<float> leafX(n), leafY(n), leafZ(n), leafR(n);
+	for (int i = 0; i < n; i++)
+	{
+		int sphere = buildOrder[i];
+		leafIds[i] = ids[sphere];
+		leafX[i] = x[sphere]; leafY[i] = y[sphere]; leafZ[i] = z[sphere]; leafR[i] = r[sphere];
+		leafOf[sphere] = i;
+	}
+	ids.swap(leafIds);
+	x.swap(leafX); y.swap(leafY); z.swap(leafZ); r.swap(leafR);
+	buildOrder.swap(leafOf);
+}
+
+AsteroidBVH::BuildNode* AsteroidBVH::buildRange(int begin, int end, int depth)
+{
+	const float* centers[3] = { &x[0], &y[0], &z[0] };
+	BuildNode* node = new BuildNode();
+	node->children[0] = node->children[1] = nullptr;
+	node->begin = begin;
+	node->count = end - begin;
+
+	// Bounds of the spheres and of their centers.
+	float centerMin[3] = { FLT_MAX, FLT_MAX, FLT_MAX }, centerMax[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+	for (int a = 0; a < 3; a++)
+	{
+		node->min[a] = FLT_MAX;
+		node->max[a] = -FLT_MAX;
+	}
+	for (int i = begin; i < end; i++)
+	{
+		int sphere = buildOrder[i];
+		for (int a = 0; a < 3; a++)
+		{
+			float c = centers[a][sphere];
+			node->min[a] = std::min(node->min[a], c - r[sphere]);
+			node->max[a] = std::max(node->max[a], c + r[sphere]);
+			centerMin[a] = std::min(centerMin[a], c);
+			centerMax[a] = std::max(centerMax[a], c);
+		}
+	}
+
+	// Clustered spheres can make the splits lopsided: the tree is kept shallow enough for the
+	// traversal stacks whatever the leaves grow to.
+	if (node->count <= 1 || depth >= BVH_MAX_DEPTH) return node;
+
+	// Split on the axis along which the centers are most spread out.
+	int axis = 0;
+	for (int a = 1; a < 3; a++)
+		if (centerMax[a] - centerMin[a] > centerMax[axis] - centerMin[axis]) axis = a;
+	float extent = centerMax[axis] - centerMin[axis];
+	if (extent == 0) return node;
+
+	Bin bins[BVH_BINS];
+	for (int b = 0; b < BVH_BINS; b++)
+		bins[b].reset();
+	float scale = BVH_BINS / extent;
+	for (int i = begin; i < end; i++)
+	{
+		int sphere = buildOrder[i];
+		int b = std::min((int)((centers[axis][sphere] - centerMin[axis]) * scale), BVH_BINS - 1);
+		for (int a = 0; a < 3; a++)
+		{
+			bins[b].min[a] = std::min(bins[b].min[a], centers[a][sphere] - r[sphere]);
+			bins[b].max[a] = std::max(bins[b].max[a], centers[a][sphere] + r[sphere]);
+		}
+		bins[b].count++;
+	}
+
+	// Cost of splitting after each bin, from sweeps of growing bounds from both ends.
+	float leftCost[BVH_BINS - 1];
+	Bin left, right;
+	left.reset();
+	for (int b = 0; b < BVH_BINS - 1; b++)
+	{
+		left.grow(bins[b]);
+		leftCost[b] = left.halfArea() * left.count;
+	}
+	int split = -1;
+	float bestCost = FLT_MAX;
+	right.reset();
+	for (int b = BVH_BINS - 1; b > 0; b--)
+	{
+		right.grow(bins[b]);
+		float cost = leftCost[b - 1] + right.halfArea() * right.count;
+		if (cost < bestCost)
+		{
+			bestCost = cost;
+			split = b;
+		}
+	}
+
+	// Keep small ranges as a leaf when splitting does not pay for visiting the extra nodes.
+	float ex = node->max[0] - node->min[0], ey = node->max[1] - node->min[1], ez = node->max[2] - node->min[2];
+	float area = ex * ey + ey * ez + ez * ex;
+	if (node->count <= BVH_LEAF_SIZE && area * node->count <= area + bestCost) return node;
+
+	int* first = &buildOrder[0] + begin;
+	int* last = &buildOrder[0] + end;
+	int* middle = std::partition(first, last, [&](int sphere) {
+		return std::min((int)((centers[axis][sphere] - centerMin[axis]) * scale), BVH_BINS - 1) < split;
+	});
+	if (middle == first || middle == last)
+	{
+		// All centers fell in one bin: split at the median instead.
+		middle = first + (last - first) / 2;
+		std::nth_element(first, middle, last, [&](int a, int b) { return centers[axis][a] < centers[axis][b]; });
+	}
+	int mid = begin + (int)(middle - first);
+
+	// The two halves cover disjoint ranges of buildOrder, so big ones can be built in parallel.
+	if (end - begin > BVH_PARALLEL_SIZE && depth < 4)
+	{
+		future<BuildNode*> firstHalf = async(launch::async, &AsteroidBVH::buildRange, this, begin, mid, depth + 1);
+		node->children[1] = buildRange(mid, end, depth + 1);
+		node->children[0] = firstHalf.get();
+	}
+	else
+	{
+		node->children[0] = buildRange(begin, mid, depth + 1);
+		node->children[1] = buildRange(mid, end, depth + 1);
+	}
+	node->count = 0;
+	return node;
+}
+
+void AsteroidBVH::flatten(BuildNode* node)
+{
+	int index = (int)nodes.size();
+	BVHNode flat;
+	flat.minX = node->min[0]; flat.minY = node->min[1]; flat.minZ = node->min[2];
+	flat.maxX = node->max[0]; flat.maxY = node->max[1]; flat.maxZ = node->max[2];
+	flat.count = node->count;
+	flat.offset = node->begin;
+	nodes.push_back(flat);
+
+	if (node->count == 0)
+	{
+		flatten(node->children[0]);
+		nodes[index].offset = (int)nodes.size();
+		flatten(node->children[1]);
+	}
+	delete node;
+}
+
+void AsteroidBVH::refit(const float* cx, const float* cy, const float* cz)
+{
+	int n = (int)ids.size();
+	for (int i = 0; i < n; i++)
+	{
+		int leaf = buildOrder[i];
+		x[leaf] = cx[i];
+		y[leaf] = cy[i];
+		z[leaf] = cz[i];
+	}
+
+	// Children come after their parent, so walking backwards updates them first.
+	for (int index = (int)nodes.size() - 1; index >= 0; index--)
+	{
+		BVHNode& node = nodes[index];
+		if (node.count > 0)
+		{
+			node.minX = node.minY = node.minZ = FLT_MAX;
+			node.maxX = node.maxY = node.maxZ = -FLT_MAX;
+			for (int i = node.offset; i < node.offset + node.count; i++)
+			{
+				node.minX = std::min(node.minX, x[i] - r[i]); node.maxX = std::max(node.maxX, x[i] + r[i]);
+				node.minY = std::min(node.minY, y[i] - r[i]); node.maxY = std::max(node.maxY, y[i] + r[i]);
+				node.minZ = std::min(node.minZ, z[i] - r[i]); node.maxZ = std::max(node.maxZ, z[i] + r[i]);
+			}
+		}
+		else
+		{
+			const BVHNode& a = nodes[index + 1];
+			const BVHNode& b = nodes[node.offset];
+			node.minX = std::min(a.minX, b.minX); node.maxX = std::max(a.maxX, b.maxX);
+			node.minY = std::min(a.minY, b.minY); node.maxY = std::max(a.maxY, b.maxY);
+			node.minZ = std::min(a.minZ, b.minZ); node.maxZ = std::max(a.maxZ, b.maxZ);
+		}
+	}
+}
+
+void AsteroidBVH::queryFrustum(const float planes[6][4], vector<int>& result, float minRadius)
+{
+	if (nodes.empty()) return;
+
+	int stack[BVH_STACK_SIZE];
+	int top = 0;
+	stack[top++] = 0;
+	while (top > 0)
+	{
+		const BVHNode& node = nodes[stack[--top]];
+
+		// The box is outside if its corner furthest along a plane's normal is outside that plane,
+		// by more than minRadius as it bounds the centers.
+		bool outside = false;
+		for (int p = 0; p < 6 && !outside; p++)
+		{
+			const float* plane = planes[p];
+			float px = plane[0] >= 0 ? node.maxX : node.minX;
+			float py = plane[1] >= 0 ? node.maxY : node.minY;
+			float pz = plane[2] >= 0 ? node.maxZ : node.minZ;
+			outside = plane[0] * px + plane[1] * py + plane[2] * pz + plane[3] < -minRadius;
+		}
+		if (outside) continue;
+
+		if (node.count > 0)
+		{
+			for (int i = node.offset; i < node.offset + node.count; i++)
+			{
+				bool visible = true;
+				for (int p = 0; p < 6 && visible; p++)
+					visible = planes[p][0] * x[i] + planes[p][1] * y[i] + planes[p][2] * z[i] + planes[p][3] >= -std::max(r[i], minRadius);
+				if (visible) result.push_back(ids[i]);
+			}
+		}
+		else
+		{
+			stack[top++] = node.offset;
+			stack[top++] = (int)(&node - &nodes[0]) + 1;
+		}
+	}
+}
+
+void AsteroidBVH::querySphere(float sx, float sy, float sz, float sr, vector<int>& result)
+{
+	if (nodes.empty()) return;
+
+	int stack[BVH_STACK_SIZE];
+	int top = 0;
+	stack[top++] = 0;
+	while (top > 0)
+	{
+		int index = stack[--top];
+		const BVHNode& node = nodes[index];
+
+		// Squared distance from the center to the box.
+		float dx = std::max(std::max(node.minX - sx, sx - node.maxX), 0.0f);
+		float dy = std::max(std::max(node.minY - sy, sy - node.maxY), 0.0f);
+		float dz = std::max(std::max(node.minZ - sz, sz - node.maxZ), 0.0f);
+		if (dx*dx + dy*dy + dz*dz > sr*sr) continue;
+
+		if (node.count > 0)
+		{
+			for (int i = node.offset; i < node.offset + node.count; i++)
+			{
+				float ex = x[i] - sx, ey = y[i] - sy, ez = z[i] - sz;
+				if (ex*ex + ey*ey + ez*ez <= (r[i] + sr) * (r[i] + sr)) result.push_back(ids[i]);
+			}
+		}
+		else
+		{
+			stack[top++] = node.offset;
+			stack[top++] = index + 1;
+		}
+	}
+}
+
+// Return the distance along the ray at which it enters the box, or FLT_MAX if it misses it.
+static float rayBoxEntry(const BVHNode& node, float ox, float oy, float oz,
+	float inverseX, float inverseY, float inverseZ, float maxDistance)
+{
+	float tx1 = (node.minX - ox) * inverseX, tx2 = (node.maxX - ox) * inverseX;
+	float ty1 = (node.minY - oy) * inverseY, ty2 = (node.maxY - oy) * inverseY;
+	float tz1 = (node.minZ - oz) * inverseZ, tz2 = (node.maxZ - oz) * inverseZ;
+	float entry = std::max(std::max(std::min(tx1, tx2), std::min(ty1, ty2)), std::max(std::min(tz1, tz2), 0.0f));
+	float exit = std::min(std::min(std::max(tx1, tx2), std::max(ty1, ty2)), std::min(std::max(tz1, tz2), maxDistance));
+	return entry <= exit ? entry : FLT_MAX;
+}
+
+int AsteroidBVH::queryRay(float ox, float oy, float oz, float dx, float dy, float dz, float maxDistance, float& distance)
+{
+	int hit = -1;
+	distance = maxDistance;
+	if (nodes.empty()) return hit;
+
+	float inverseX = 1 / dx, inverseY = 1 / dy, inverseZ = 1 / dz;
+	int stack[BVH_STACK_SIZE];
+	int top = 0;
+	stack[top++] = 0;
+	while (top > 0)
+	{
+		int index = stack[--top];
+		const BVHNode& node = nodes[index];
+		if (rayBoxEntry(node, ox, oy, oz, inverseX, inverseY, inverseZ, distance) == FLT_MAX) continue;
+
+		if (node.count > 0)
+		{
+			for (int i = node.offset; i < node.offset + node.count; i++)
+			{
+				float t;
+				if (glm::intersectRaySphere(glm::vec3(ox, oy, oz), glm::vec3(dx, dy, dz),
+					glm::vec3(x[i], y[i], z[i]), r[i] * r[i], t) && t < distance)
+				{
+					distance = t;
+					hit = ids[i];
+				}
+			}
+		}
+		else
+		{
+			// Visit the nearer child first so that the further one is likely culled.
+			int nearChild = index + 1, farChild = node.offset;
+			float nearEntry = rayBoxEntry(nodes[nearChild], ox, oy, oz, inverseX, inverseY, inverseZ, distance);
+			float farEntry = rayBoxEntry(nodes[farChild], ox, oy, oz, inverseX, inverseY, inverseZ, distance);
+			if (farEntry < nearEntry)
+			{
+				std::swap(nearChild, farChild);
+				std::swap(nearEntry, farEntry);
+			}
+			if (farEntry != FLT_MAX) stack[top++] = farChild;
+			if (nearEntry != FLT_MAX) stack[top++] = nearChild;
+		}
+	}
+	return hit;
+}
+
+// Keep the lanes of a where mask is set and the lanes of b elsewhere.
+static inline __m128 select(__m128 mask, __m128 a, __m128 b)
+{
+	return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+void AsteroidBVH::queryRays(const RayPacket& packet, int hit[4], float distance[4])
+{
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 epsilon = _mm_set1_ps(numeric_limits<float>::epsilon());
+	__m128 ox = _mm_loadu_ps(packet.originX), oy = _mm_loadu_ps(packet.originY), oz = _mm_loadu_ps(packet.originZ);
+	__m128 dx = _mm_loadu_ps(packet.directionX), dy = _mm_loadu_ps(packet.directionY), dz = _mm_loadu_ps(packet.directionZ);
+	__m128 one = _mm_set1_ps(1.0f);
+	__m128 inverseX = _mm_div_ps(one, dx), inverseY = _mm_div_ps(one, dy), inverseZ = _mm_div_ps(one, dz);
+	__m128 nearest = _mm_loadu_ps(packet.maxDistance);
+	__m128 nearestId = _mm_castsi128_ps(_mm_set1_epi32(-1));
+
+	if (!nodes.empty())
+	{
+		int stack[BVH_STACK_SIZE];
+		int top = 0;
+		stack[top++] = 0;
+		while (top > 0)
+		{
+			int index = stack[--top];
+			const BVHNode& node = nodes[index];
+
+			// Slab test of the four rays against the box, each up to its nearest hit so far.
+			__m128 tx1 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.minX), ox), inverseX);
+			__m128 tx2 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.maxX), ox), inverseX);
+			__m128 ty1 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.minY), oy), inverseY);
+			__m128 ty2 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.maxY), oy), inverseY);
+			__m128 tz1 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.minZ), oz), inverseZ);
+			__m128 tz2 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.maxZ), oz), inverseZ);
+			__m128 entry = _mm_max_ps(_mm_max_ps(_mm_min_ps(tx1, tx2), _mm_min_ps(ty1, ty2)),
+				_mm_max_ps(_mm_min_ps(tz1, tz2), zero));
+			__m128 exit = _mm_min_ps(_mm_min_ps(_mm_max_ps(tx1, tx2), _mm_max_ps(ty1, ty2)),
+				_mm_min_ps(_mm_max_ps(tz1, tz2), nearest));
+			if (_mm_movemask_ps(_mm_cmple_ps(entry, exit)) == 0) continue;
+
+			if (node.count == 0)
+			{
+				stack[top++] = node.offset;
+				stack[top++] = index + 1;
+				continue;
+			}
+
+			// Same test as glm::intersectRaySphere, for the four rays at once.
+			for (int i = node.offset; i < node.offset + node.count; i++)
+			{
+				__m128 diffX = _mm_sub_ps(_mm_set1_ps(x[i]), ox);
+				__m128 diffY = _mm_sub_ps(_mm_set1_ps(y[i]), oy);
+				__m128 diffZ = _mm_sub_ps(_mm_set1_ps(z[i]), oz);
+				__m128 t0 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(diffX, dx), _mm_mul_ps(diffY, dy)), _mm_mul_ps(diffZ, dz));
+				__m128 dSquared = _mm_sub_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(diffX, diffX), _mm_mul_ps(diffY, diffY)),
+					_mm_mul_ps(diffZ, diffZ)), _mm_mul_ps(t0, t0));
+				__m128 radiusSquared = _mm_set1_ps(r[i] * r[i]);
+				__m128 t1 = _mm_sqrt_ps(_mm_max_ps(_mm_sub_ps(radiusSquared, dSquared), zero));
+				__m128 t = select(_mm_cmpgt_ps(t0, _mm_add_ps(t1, epsilon)), _mm_sub_ps(t0, t1), _mm_add_ps(t0, t1));
+
+				__m128 closer = _mm_and_ps(_mm_and_ps(_mm_cmple_ps(dSquared, radiusSquared), _mm_cmpgt_ps(t, epsilon)),
+					_mm_cmplt_ps(t, nearest));
+				nearest = select(closer, t, nearest);
+				nearestId = select(closer, _mm_castsi128_ps(_mm_set1_epi32(ids[i])), nearestId);
+			}
+		}
+	}
+
+	_mm_storeu_ps(distance, nearest);
+	_mm_storeu_si128((__m128i*)hit, _mm_castps_si128(nearestId));
+}
+
+void AsteroidBVH::queryRays(const float* ox, const float* oy, const float* oz,
+	const float* dx, const float* dy, const float* dz, float maxDistance, int n, int* hits, float* distances)
+{
+	RayPacket packet;
+	int hit[4];
+	float distance[4];
+
+	for (int first = 0; first < n; first += 4)
+	{
+		for (int lane = 0; lane < 4; lane++)
+		{
+			// Lanes past the last ray are filled with a copy of it that cannot hit anything.
+			int ray = first + lane < n ? first + lane : n - 1;
+			packet.originX[lane] = ox[ray]; packet.originY[lane] = oy[ray]; packet.originZ[lane] = oz[ray];
+			packet.directionX[lane] = dx[ray]; packet.directionY[lane] = dy[ray]; packet.directionZ[lane] = dz[ray];
+			packet.maxDistance[lane] = first + lane < n ? maxDistance : -1.0f;
+		}
+
+		queryRays(packet, hit, distance);
+
+		for (int lane = 0; lane < 4 && first + lane < n; lane++)
+		{
+			hits[first + lane] = hit[lane];
+			distances[first + lane] = distance[lane];
+		}
+	}
+}
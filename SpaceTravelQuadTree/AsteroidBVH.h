@@ -0,0 +1,88 @@
+#pragma once
+
+#include <vector>
+
+using namespace std;
+
+#define BVH_BINS 12 // Candidate split planes tried per axis by the SAH builder.
+#define BVH_LEAF_SIZE 4 // Largest number of spheres a leaf is made with.
+#define BVH_PARALLEL_SIZE 4096 // Subtrees with more spheres than this are built on their own thread.
+#define BVH_MAX_DEPTH 48 // Deepest a node is made: ranges still left there become leaves.
+#define BVH_STACK_SIZE 64 // Nodes a traversal keeps to visit, one more than the depth at most.
+
+// Node of the flattened hierarchy, 32 bytes. Nodes are laid out depth-first, so the first child
+// of an inner node directly follows it and only the second child's index has to be stored.
+struct BVHNode
+{
+	float minX, minY, minZ;
+	int offset; // Inner node: index of the second child. Leaf: index of its first sphere.
+	float maxX, maxY, maxZ;
+	int count; // Number of spheres in a leaf, 0 for an inner node.
+};
+static_assert(sizeof(BVHNode) == 32, "BVH nodes should fill half a cache line");
+
+// Four rays in structure-of-arrays layout, traced through the hierarchy together.
+struct RayPacket
+{
+	float originX[4], originY[4], originZ[4];
+	float directionX[4], directionY[4], directionZ[4]; // Unit length.
+	float maxDistance[4]; // Negative for a lane that is not in use.
+};
+
+// Bounding volume hierarchy over spheres in 3D, built with the surface area heuristic over
+// binned centroids. Objects are identified by the ids given to build().
+class AsteroidBVH
+{
+public:
+	// Build the hierarchy over the n spheres centered at (x[i],y[i],z[i]) of radius r[i].
+	void build(const int* ids, const float* x, const float* y, const float* z, const float* r, int n);
+
+	// Move the spheres to new centers, given in the same order as to build(), and recompute
+	// the node bounds while keeping the tree. Cheap, but the tree degrades if the spheres
+	// move far from where they were at build time.
+	void refit(const float* x, const float* y, const float* z);
+
+	// Append the id of every sphere at least partly on the inner side (a x + b y + c z + d >= 0)
+	// of all six planes (a, b, c, d), given with unit normals (a, b, c). Spheres count as having
+	// a radius of at least minRadius, for what is drawn around them being larger.
+	void queryFrustum(const float planes[6][4], vector<int>& ids, float minRadius = 0);
+
+	// Append the id of every sphere intersecting the sphere centered at (x,y,z) of radius r.
+	void querySphere(float x, float y, float z, float r, vector<int>& ids);
+
+	// Return the id of the first sphere hit by the ray from (ox,oy,oz) along the unit direction
+	// (dx,dy,dz) within maxDistance, setting distance to that hit, or -1 if none is hit.
+	// A ray starting inside a sphere hits it where it leaves it, as with glm::intersectRaySphere.
+	int queryRay(float ox, float oy, float oz, float dx, float dy, float dz, float maxDistance, float& distance);
+
+	// Same as queryRay for the four rays of the packet, traversing the hierarchy once with
+	// SSE for all of them. Writes -1 to hit, and the ray's max distance to distance, for the
+	// rays that hit nothing.
+	void queryRays(const RayPacket& packet, int hit[4], float distance[4]);
+
+	// Same as queryRay for n rays given as separate arrays of origins and unit directions,
+	// traced in packets of four.
+	void queryRays(const float* ox, const float* oy, const float* oz,
+		const float* dx, const float* dy, const float* dz, float maxDistance, int n, int* hits, float* distances);
+
+	int getNodeCount() { return (int)nodes.size(); }
+	const BVHNode& getNode(int node) { return nodes[node]; }
+
+	// Spheres in leaf order: leaf nodes refer to ranges of these arrays.
+	const int* getIds() { return &ids[0]; }
+	const float* getX() { return &x[0]; }
+	const float* getY() { return &y[0]; }
+	const float* getZ() { return &z[0]; }
+	const float* getRadius() { return &r[0]; }
+
+private:
+	struct BuildNode;
+
+	vector<BVHNode> nodes;
+	vector<int> ids;
+	vector<float> x, y, z, r;
+	vector<int> buildOrder; // Position in leaf order of each sphere as given to build().
+
+	BuildNode* buildRange(int begin, int end, int depth);
+	void flatten(BuildNode* node);
+};
@@ -0,0 +1,284 @@
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <utility>
+
+#include "AsteroidField.h"
+#include "Profiler.h"
+#include "collisionDetectionRoutines.h"
+
+AsteroidField::~AsteroidField()
+{
+	release();
+}
+
+void AsteroidField::release()
+{
+	if (asteroids)
+	{
+		for (int i = 0; i < ROWS; i++)
+			delete[] asteroids[i];
+		delete[] asteroids;
+		asteroids = nullptr;
+	}
+}
+
+// Last revision given to any field. Fields may be generated on other threads.
+static atomic<unsigned int> revisions(0);
+
+// Return a random float in [-max, max].
+static float randomSigned(float max)
+{
+	return max * (2.0f * rand() / RAND_MAX - 1.0f);
+}
+
+float AsteroidField::getColumnOffset()
+{
+	// Position the asteroids depending on if there is an even or odd number of columns
+	// so that the spacecraft faces the middle of the asteroid field.
+	float oddevenOffset = (COLUMNS % 2) ? 0.0f : ASTEROID_SPACING / 2;
+	return oddevenOffset - ASTEROID_SPACING * (COLUMNS / 2);
+}
+
+void AsteroidField::generate(const FieldConfig& config)
+{
+	int i, j;
+
+	if (config.seed != 0) srand(config.seed);
+	float radius = config.radius < ASTEROID_GRID_SLACK ? config.radius : ASTEROID_GRID_SLACK;
+
+	// create memory for each potential asteroid
+	release();
+	asteroids = new Asteroid *[ROWS];
+	for (i = 0; i < ROWS; i++) {
+		asteroids[i] = new Asteroid[COLUMNS];
+	}
+
+	float offset = getColumnOffset();
+
+	for (j = 0; j < COLUMNS; j++)
+		for (i = 0; i < ROWS; i++)
+			if (rand() % 100 < config.fillProbability)
+				// If rand()%100 >= fillProbability the default constructor asteroid remains in the slot which
+				// indicates that there is no asteroid there because the default's radius is 0.
+			{
+				float y = config.height > 0 ? randomSigned(config.height) : 0.0f;
+				asteroids[i][j] = Asteroid(offset + ASTEROID_SPACING * j, y, ASTEROID_FIELD_Z - ASTEROID_SPACING * i,
+					radius, rand() % 256, rand() % 256, rand() % 256);
+
+				if (config.maxSpeed > 0 || config.maxSpin > 0)
+				{
+					asteroids[i][j].setVelocity(randomSigned(config.maxSpeed), 0.0, randomSigned(config.maxSpeed));
+					asteroids[i][j].setSpinRate(randomSigned(config.maxSpin));
+				}
+			}
+
+	// Index the asteroids in a grid with one cell per slot.
+	grid.init(offset - ASTEROID_SPACING / 2, ASTEROID_FIELD_Z - ASTEROID_SPACING * (ROWS - 0.5f),
+		offset + ASTEROID_SPACING * (COLUMNS - 0.5f), ASTEROID_FIELD_Z + ASTEROID_SPACING / 2,
+		ASTEROID_SPACING, ASTEROID_GRID_SLACK);
+
+	moving = false;
+	for (i = 0; i < ROWS; i++)
+		for (j = 0; j < COLUMNS; j++)
+		{
+			Asteroid& asteroid = asteroids[i][j];
+			if (asteroid.getRadius() > 0) // If asteroid exists.
+			{
+				grid.insert(i * COLUMNS + j, asteroid.getCenterX(), asteroid.getCenterZ());
+				moving = moving || asteroid.isMoving();
+			}
+		}
+
+	revision = ++revisions;
+	gatherBodies();
+	if (!bodies.empty())
+		bvh.build(&bodies[0], &bodyX[0], &bodyY[0], &bodyZ[0], &bodyRadius[0], (int)bodies.size());
+}
+
+bool AsteroidField::loadConfig(const char* file, FieldConfig& config)
+{
+	ifstream in(file);
+	if (!in) return false;
+
+	string line;
+	int number = 0;
+	while (getline(in, line))
+	{
+		number++;
+		line = line.substr(0, line.find('#')); // Comments run to the end of the line.
+		istringstream words(line);
+		string key, equals;
+		if (!(words >> key)) continue; // Blank line.
+
+		bool parsed = (bool)(words >> equals) && equals == "=";
+		if (parsed)
+		{
+			if (key == "fillProbability") parsed = (bool)(words >> config.fillProbability);
+			else if (key == "radius") parsed = (bool)(words >> config.radius);
+			else if (key == "height") parsed = (bool)(words >> config.height);
+			else if (key == "maxSpeed") parsed = (bool)(words >> config.maxSpeed);
+			else if (key == "maxSpin") parsed = (bool)(words >> config.maxSpin);
+			else if (key == "seed") parsed = (bool)(words >> config.seed);
+			else parsed = false;
+		}
+		if (!parsed)
+		{
+			cerr << file << ":" << number << ": expected one of fillProbability, radius, height, maxSpeed, "
+				<< "maxSpin or seed followed by = and a number" << endl;
+			return false;
+		}
+	}
+	return true;
+}
+
+void AsteroidField::swap(AsteroidField& other)
+{
+	std::swap(asteroids, other.asteroids);
+	std::swap(grid, other.grid);
+	std::swap(bvh, other.bvh);
+	std::swap(moving, other.moving);
+	std::swap(revision, other.revision);
+	std::swap(largestRadius, other.largestRadius);
+	std::swap(sweepAndPrune, other.sweepAndPrune);
+	bodies.swap(other.bodies);
+	bodyX.swap(other.bodyX); bodyY.swap(other.bodyY); bodyZ.swap(other.bodyZ); bodyRadius.swap(other.bodyRadius);
+	pairs.swap(other.pairs);
+	pairX1.swap(other.pairX1); pairY1.swap(other.pairY1); pairZ1.swap(other.pairZ1); pairRadius1.swap(other.pairRadius1);
+	pairX2.swap(other.pairX2); pairY2.swap(other.pairY2); pairZ2.swap(other.pairZ2); pairRadius2.swap(other.pairRadius2);
+	pairHit.swap(other.pairHit);
+}
+
+void AsteroidField::gatherBodies()
+{
+	bodies.clear();
+	bodyX.clear(); bodyY.clear(); bodyZ.clear(); bodyRadius.clear();
+	largestRadius = 0;
+	for (int i = 0; i < ROWS; i++)
+		for (int j = 0; j < COLUMNS; j++)
+		{
+			Asteroid& asteroid = asteroids[i][j];
+			if (asteroid.getRadius() > 0) // If asteroid exists.
+			{
+				bodies.push_back(i * COLUMNS + j);
+				bodyX.push_back(asteroid.getCenterX());
+				bodyY.push_back(asteroid.getCenterY());
+				bodyZ.push_back(asteroid.getCenterZ());
+				bodyRadius.push_back(asteroid.getRadius());
+				largestRadius = max(largestRadius, asteroid.getRadius());
+			}
+		}
+}
+
+void AsteroidField::step(float dt)
+{
+	if (!moving) return;
+
+	int i, j;
+	for (i = 0; i < ROWS; i++)
+		for (j = 0; j < COLUMNS; j++)
+			if (asteroids[i][j].getRadius() > 0 && asteroids[i][j].isMoving())
+				asteroids[i][j].move(dt);
+
+	collideAsteroids();
+
+	for (i = 0; i < ROWS; i++)
+		for (j = 0; j < COLUMNS; j++)
+		{
+			Asteroid& asteroid = asteroids[i][j];
+			if (asteroid.getRadius() > 0)
+				grid.update(i * COLUMNS + j, asteroid.getCenterX(), asteroid.getCenterZ(), asteroid.getRadius());
+		}
+
+	Profiler::getInstance().setCounter("asteroid grid reinsertions", grid.takeReinsertions());
+
+	revision = ++revisions;
+
+	// Asteroids stay in the same order, so the hierarchy only needs its bounds refitted.
+	gatherBodies();
+	if (!bodies.empty())
+		bvh.refit(&bodyX[0], &bodyY[0], &bodyZ[0]);
+}
+
+void AsteroidField::collideAsteroids()
+{
+	Profiler& profiler = Profiler::getInstance();
+	int i;
+
+	gatherBodies();
+	if (bodies.empty()) return;
+
+	pairs.clear();
+	sweepAndPrune.findPairs(&bodyX[0], &bodyY[0], &bodyZ[0], &bodyRadius[0], (int)bodies.size(), pairs);
+	profiler.setCounter("asteroid sweep and prune swaps", sweepAndPrune.takeSwaps());
+	profiler.setCounter("asteroid pairs", (double)pairs.size());
+	if (pairs.empty()) return;
+
+	int n = (int)pairs.size();
+	pairX1.resize(n); pairY1.resize(n); pairZ1.resize(n); pairRadius1.resize(n);
+	pairX2.resize(n); pairY2.resize(n); pairZ2.resize(n); pairRadius2.resize(n);
+	pairHit.resize(n);
+	for (i = 0; i < n; i++)
+	{
+		int a = pairs[i].first, b = pairs[i].second;
+		pairX1[i] = bodyX[a]; pairY1[i] = bodyY[a]; pairZ1[i] = bodyZ[a]; pairRadius1[i] = bodyRadius[a];
+		pairX2[i] = bodyX[b]; pairY2[i] = bodyY[b]; pairZ2[i] = bodyZ[b]; pairRadius2[i] = bodyRadius[b];
+	}
+	checkSpheresIntersection(&pairX1[0], &pairY1[0], &pairZ1[0], &pairRadius1[0],
+		&pairX2[0], &pairY2[0], &pairZ2[0], &pairRadius2[0], n, &pairHit[0]);
+
+	int contacts = 0;
+	for (i = 0; i < n; i++)
+		if (pairHit[i])
+		{
+			bounce(get(bodies[pairs[i].first]), get(bodies[pairs[i].second]));
+			contacts++;
+		}
+	profiler.setCounter("asteroid contacts", contacts);
+}
+
+// Resolve the contact between two overlapping asteroids with an elastic collision, taking the
+// mass of an asteroid to grow with the cube of its radius, and push them apart.
+void AsteroidField::bounce(Asteroid& a, Asteroid& b)
+{
+	float nx = b.getCenterX() - a.getCenterX();
+	float ny = b.getCenterY() - a.getCenterY();
+	float nz = b.getCenterZ() - a.getCenterZ();
+	float distance = sqrt(nx*nx + ny*ny + nz*nz);
+	if (distance == 0) return;
+
+	// An earlier bounce of this step may already have pushed them apart.
+	float depth = a.getRadius() + b.getRadius() - distance;
+	if (depth <= 0) return;
+	nx /= distance; ny /= distance; nz /= distance;
+
+	float inverseMassA = 1 / (a.getRadius() * a.getRadius() * a.getRadius());
+	float inverseMassB = 1 / (b.getRadius() * b.getRadius() * b.getRadius());
+	float inverseMassSum = inverseMassA + inverseMassB;
+
+	// Exchange momentum along the normal if they are closing in.
+	float closing = (b.getVelocityX() - a.getVelocityX()) * nx + (b.getVelocityY() - a.getVelocityY()) * ny +
+		(b.getVelocityZ() - a.getVelocityZ()) * nz;
+	if (closing < 0)
+	{
+		float impulse = -2 * closing / inverseMassSum;
+		a.setVelocity(a.getVelocityX() - impulse * inverseMassA * nx, a.getVelocityY() - impulse * inverseMassA * ny,
+			a.getVelocityZ() - impulse * inverseMassA * nz);
+		b.setVelocity(b.getVelocityX() + impulse * inverseMassB * nx, b.getVelocityY() + impulse * inverseMassB * ny,
+			b.getVelocityZ() + impulse * inverseMassB * nz);
+	}
+
+	// Separate them so they do not stay stuck together.
+	float pushA = depth * inverseMassA / inverseMassSum, pushB = depth * inverseMassB / inverseMassSum;
+	a.setCenter(a.getCenterX() - pushA * nx, a.getCenterY() - pushA * ny, a.getCenterZ() - pushA * nz);
+	b.setCenter(b.getCenterX() + pushB * nx, b.getCenterY() + pushB * ny, b.getCenterZ() + pushB * nz);
+}
+
+void AsteroidField::queryCandidates(float minX, float minZ, float maxX, float maxZ, vector<int>& candidates)
+{
+	grid.query(minX, minZ, maxX, maxZ, candidates);
+}
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "Asteroid.h"
+#include "AsteroidBVH.h"
+#include "LooseGrid.h"
+#include "Renderer.h"
+#include "SweepAndPrune.h"
+
+using namespace std;
+
+// Layout of the field: asteroid (i, j) sits at x = ASTEROID_SPACING * (j - COLUMNS / 2) shifted
+// to center the columns, and at z = ASTEROID_FIELD_Z - ASTEROID_SPACING * i.
+#define ASTEROID_SPACING 30.0f
+#define ASTEROID_FIELD_Z -40.0f
+#define ASTEROID_RADIUS 3.0f
+
+// Asteroids are scattered up to this far above and below the plane y = 0. Leave at 0 for the
+// classic flat field.
+#define ASTEROID_FIELD_HEIGHT 0.0f
+
+// Largest speed (units per step) and spin rate (degrees per step) given to an asteroid. Leave
+// both at 0 for a field that never moves.
+#define ASTEROID_MAX_SPEED 0.0f
+#define ASTEROID_MAX_SPIN 0.0f
+
+// How far an asteroid may stray out of its grid cell before it is moved to another one.
+#define ASTEROID_GRID_SLACK (ASTEROID_SPACING / 2)
+
+#define FIELD_CONFIG_FILE "field.cfg" // Optional overrides of FieldConfig, one "key = value" per line.
+
+// Parameters of a generated field that can change without rebuilding, defaulting to the
+// constants above. The layout (ROWS, COLUMNS, ASTEROID_SPACING) is fixed.
+struct FieldConfig
+{
+	int fillProbability = FILL_PROBABILITY; // Percentage of slots with an asteroid.
+	float radius = ASTEROID_RADIUS; // At most ASTEROID_GRID_SLACK.
+	float height = ASTEROID_FIELD_HEIGHT;
+	float maxSpeed = ASTEROID_MAX_SPEED;
+	float maxSpin = ASTEROID_MAX_SPIN;
+	unsigned int seed = 0; // Seed of the random layout, or 0 to continue the current sequence.
+};
+
+// The asteroid field. Owns the ROWS x COLUMNS grid of asteroid slots and answers
+// broadphase queries against it through a loose grid that follows the asteroids as they move.
+// A bounding volume hierarchy, whose ids are asteroid indices, serves the 3D frustum, sphere
+// and ray queries. The game plays in the getInstance() field; other fields may be made to
+// generate a replacement off the main thread.
+class AsteroidField
+{
+public:
+	void generate(const FieldConfig& config = FieldConfig());
+
+	// Read the keys of the config file into config, leaving the others as they are. Return false
+	// if the file cannot be read or has a line that is not a known "key = value".
+	static bool loadConfig(const char* file, FieldConfig& config);
+
+	// Exchange the contents of two fields, e.g., to replace the field with one generated in the
+	// background without any copying.
+	void swap(AsteroidField& other);
+
+	// Move every asteroid by dt steps of its velocity and spin, bounce asteroids that hit each
+	// other apart, and update the spatial index.
+	void step(float dt);
+	bool isMoving() { return moving; }
+
+	// Changes whenever the asteroids are generated, swapped in or moved, and differs between
+	// fields, so that what is drawn of a field can be kept until then.
+	unsigned int getRevision() { return revision; }
+
+	// Radius of the largest asteroid, 0 for an empty field.
+	float getLargestRadius() { return largestRadius; }
+
+	Asteroid** getAsteroids() { return asteroids; }
+	Asteroid& get(int index) { return asteroids[index / COLUMNS][index % COLUMNS]; }
+
+	// Append to candidates the index (row * COLUMNS + column) of every existing asteroid
+	// that may overlap the axis-aligned box [minX, maxX] x [minZ, maxZ] of the xz-plane.
+	void queryCandidates(float minX, float minZ, float maxX, float maxZ, vector<int>& candidates);
+
+	AsteroidBVH& getBVH() { return bvh; }
+
+	// x of column 0, so that the spacecraft faces the middle of the field.
+	float getColumnOffset();
+
+	AsteroidField() {}
+	~AsteroidField();
+	static AsteroidField& getInstance() {
+		static AsteroidField instance;
+		return instance;
+	}
+
+private:
+	Asteroid** asteroids = nullptr;
+	LooseGrid grid;
+	AsteroidBVH bvh;
+	bool moving = false; // Does any asteroid move?
+	unsigned int revision = 0;
+	float largestRadius = 0;
+
+	// The existing asteroids gathered into arrays for the broadphases, and the overlapping pairs
+	// gathered into arrays for the asteroid-asteroid narrowphase.
+	SweepAndPrune sweepAndPrune;
+	vector<int> bodies;
+	vector<float> bodyX, bodyY, bodyZ, bodyRadius;
+	vector<pair<int, int> > pairs;
+	vector<float> pairX1, pairY1, pairZ1, pairRadius1, pairX2, pairY2, pairZ2, pairRadius2;
+	vector<char> pairHit;
+
+	void release();
+	void gatherBodies();
+	void collideAsteroids();
+	void bounce(Asteroid& a, Asteroid& b);
+
+	AsteroidField(AsteroidField const&);
+	void operator=(AsteroidField const&);
+};
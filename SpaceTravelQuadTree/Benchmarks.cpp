@@ -0,0 +1,696 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <glm/gtc/packing.hpp>
+#include <iostream>
+#include <iterator>
+#include <thread>
+
+#include "Benchmarks.h"
+#include "AsteroidField.h"
+#include "CraftSystem.h"
+#include "NullBackend.h"
+#include "QualityGovernor.h"
+#include "RecordingBackend.h"
+#include "Scene.h"
+#include "ShaderCache.h"
+#include "SoftwareRenderer.h"
+#include "VertexFormats.h"
+#include "geometryKernel.h"
+#include "intersectionDetectionRoutines.h"
+
+using namespace std;
+
+#define BENCH_STEPS 20 // Steps timed for each configuration.
+#define BENCH_RAYS (1 << 20) // Rays traced by the ray benchmark.
+#define BENCH_QUADS (1 << 20) // Quadrilateral pairs tested by the quadrilateral benchmark.
+#define CHECKED_PRIMITIVES 1003 // Random primitives of each batch of the intersection check.
+#define BENCH_FRAMES 5 // Frames, at least 2, timed by the software rendering benchmark for each configuration.
+#define BENCH_SUBMITTED_FRAMES 200 // Frames timed by the submission benchmark for each configuration.
+#define BENCH_INSTANCES (1 << 20) // Asteroid instances encoded by the packing benchmark.
+#define BENCH_GOVERNED_FRAMES 3000 // Frames fed to the governor for each load.
+
+// Give every craft a scripted input: all fly forward, turning left, right or not at all in
+// turns so that they keep running into the asteroids.
+static void setScriptedInputs(CraftSystem& crafts, int step)
+{
+	for (int i = 0; i < crafts.getCount(); i++)
+		crafts.setInput(i, -1, (float)((i + step / 10) % 3 - 1));
+}
+
+int runCraftBenchmark()
+{
+	AsteroidField& field = AsteroidField::getInstance();
+	CraftSystem& crafts = CraftSystem::getInstance();
+
+	srand(1);
+	field.generate();
+
+	int maxThreads = thread::hardware_concurrency();
+	if (maxThreads < 1) maxThreads = 1;
+
+	vector<int> threadCounts;
+	for (int threads = 1; threads < maxThreads; threads *= 2)
+		threadCounts.push_back(threads);
+	threadCounts.push_back(maxThreads);
+
+	const int counts[] = { 1000, 10000, 100000 };
+	cout << "crafts\tthreads\tships/s" << endl;
+	for (int count : counts)
+	{
+		for (int threads : threadCounts)
+		{
+			// Start the crafts in the gaps between the rows and columns of asteroids.
+			crafts.clear();
+			for (int i = 0; i < count; i++)
+			{
+				int column = i % (COLUMNS - 1), row = (i / (COLUMNS - 1)) % (ROWS - 1);
+				crafts.add(field.getColumnOffset() + ASTEROID_SPACING * (column + 0.5f),
+					ASTEROID_FIELD_Z - ASTEROID_SPACING * (row + 0.5f), 0.0);
+			}
+
+			chrono::duration<double> elapsed(0);
+			for (int step = 0; step < BENCH_STEPS; step++)
+			{
+				setScriptedInputs(crafts, step);
+				chrono::high_resolution_clock::time_point start = chrono::high_resolution_clock::now();
+				crafts.update(threads);
+				elapsed += chrono::high_resolution_clock::now() - start;
+			}
+
+			cout << count << "\t" << threads << "\t" << (long long)(count * (double)BENCH_STEPS / elapsed.count()) << endl;
+		}
+	}
+	return 0;
+}
+
+int runRayBenchmark()
+{
+	AsteroidField& field = AsteroidField::getInstance();
+
+	srand(1);
+	field.generate();
+	AsteroidBVH& bvh = field.getBVH();
+
+	// Sensor sweeps from random points of the field: each craft casts a fan of four rays a
+	// degree apart, mostly along the plane of the asteroids.
+	float width = ASTEROID_SPACING * COLUMNS, depth = ASTEROID_SPACING * ROWS;
+	vector<float> ox(BENCH_RAYS), oy(BENCH_RAYS), oz(BENCH_RAYS), dx(BENCH_RAYS), dy(BENCH_RAYS), dz(BENCH_RAYS);
+	float x, z, a, e;
+	for (int i = 0; i < BENCH_RAYS; i++)
+	{
+		if (i % 4 == 0)
+		{
+			x = field.getColumnOffset() + width * rand() / RAND_MAX;
+			z = ASTEROID_FIELD_Z - depth * rand() / RAND_MAX;
+			a = (float)(2 * PI * rand() / RAND_MAX);
+			e = (float)(0.1 * rand() / RAND_MAX - 0.05);
+		}
+		float fan = a + (float)(PI / 180.0) * (i % 4);
+		ox[i] = x;
+		oy[i] = 0.0;
+		oz[i] = z;
+		dx[i] = cos(e) * sin(fan);
+		dy[i] = sin(e);
+		dz[i] = cos(e) * cos(fan);
+	}
+
+	vector<int> scalarHits(BENCH_RAYS), packetHits(BENCH_RAYS);
+	vector<float> scalarDistances(BENCH_RAYS), packetDistances(BENCH_RAYS);
+
+	chrono::high_resolution_clock::time_point start = chrono::high_resolution_clock::now();
+	for (int i = 0; i < BENCH_RAYS; i++)
+		scalarHits[i] = bvh.queryRay(ox[i], oy[i], oz[i], dx[i], dy[i], dz[i], 250.0, scalarDistances[i]);
+	chrono::duration<double> scalar = chrono::high_resolution_clock::now() - start;
+
+	start = chrono::high_resolution_clock::now();
+	bvh.queryRays(&ox[0], &oy[0], &oz[0], &dx[0], &dy[0], &dz[0], 250.0, BENCH_RAYS, &packetHits[0], &packetDistances[0]);
+	chrono::duration<double> packets = chrono::high_resolution_clock::now() - start;
+
+	int hits = 0, mismatches = 0;
+	for (int i = 0; i < BENCH_RAYS; i++)
+	{
+		if (scalarHits[i] >= 0) hits++;
+		if (scalarHits[i] != packetHits[i]) mismatches++;
+	}
+
+	cout << "rays\thit\tscalar rays/s\tpacket rays/s\tmismatches" << endl;
+	cout << BENCH_RAYS << "\t" << hits << "\t" << (long long)(BENCH_RAYS / scalar.count()) << "\t"
+		<< (long long)(BENCH_RAYS / packets.count()) << "\t" << mismatches << endl;
+	return mismatches == 0 ? 0 : 1;
+}
+
+// Write to q the vertices of a random convex quadrilateral around (x, y), in counter-clockwise
+// order, fitting in a square of side 4 about it.
+static void randomConvexQuadrilateral(float x, float y, float* q)
+{
+	float angle = (float)(2 * PI * rand() / RAND_MAX);
+	for (int k = 0; k < 4; k++)
+	{
+		angle += (float)(PI / 2 * (0.5 + 0.5 * rand() / RAND_MAX)); // Quarter turns at most.
+		float r = 1.0f + 1.0f * rand() / RAND_MAX;
+		q[2 * k] = x + r * cos(angle);
+		q[2 * k + 1] = y + r * sin(angle);
+	}
+}
+
+int runQuadBenchmark()
+{
+	srand(1);
+
+	// Centers of the second quadrilaterals are spread further from the first for sparser hits.
+	const float spreads[] = { 40.0, 8.0, 2.0 };
+	vector<float> a(8 * BENCH_QUADS), b(8 * BENCH_QUADS);
+	vector<int> general(BENCH_QUADS), fast(BENCH_QUADS);
+	int mismatches = 0;
+
+	cout << "spread\thit\tgeneral pairs/s\tSAT pairs/s\tmismatches" << endl;
+	for (float spread : spreads)
+	{
+		for (int i = 0; i < BENCH_QUADS; i++)
+		{
+			randomConvexQuadrilateral(0.0, 0.0, &a[8 * i]);
+			randomConvexQuadrilateral(spread * (2.0f * rand() / RAND_MAX - 1.0f),
+				spread * (2.0f * rand() / RAND_MAX - 1.0f), &b[8 * i]);
+		}
+
+		chrono::high_resolution_clock::time_point start = chrono::high_resolution_clock::now();
+		for (int i = 0; i < BENCH_QUADS; i++)
+		{
+			const float* p = &a[8 * i];
+			const float* q = &b[8 * i];
+			general[i] = geometry::checkGeneralQuadrilateralsIntersection(p[0], p[1], p[2], p[3], p[4], p[5], p[6], p[7],
+				q[0], q[1], q[2], q[3], q[4], q[5], q[6], q[7]);
+		}
+		chrono::duration<double> generalTime = chrono::high_resolution_clock::now() - start;
+
+		start = chrono::high_resolution_clock::now();
+		for (int i = 0; i < BENCH_QUADS; i++)
+		{
+			const float* p = &a[8 * i];
+			const float* q = &b[8 * i];
+			fast[i] = geometry::checkQuadrilateralsIntersection(p[0], p[1], p[2], p[3], p[4], p[5], p[6], p[7],
+				q[0], q[1], q[2], q[3], q[4], q[5], q[6], q[7]);
+		}
+		chrono::duration<double> fastTime = chrono::high_resolution_clock::now() - start;
+
+		int hits = 0, spreadMismatches = 0;
+		for (int i = 0; i < BENCH_QUADS; i++)
+		{
+			if (general[i]) hits++;
+			if (general[i] != fast[i]) spreadMismatches++;
+		}
+		mismatches += spreadMismatches;
+
+		cout << spread << "\t" << hits << "\t" << (long long)(BENCH_QUADS / generalTime.count()) << "\t"
+			<< (long long)(BENCH_QUADS / fastTime.count()) << "\t" << spreadMismatches << endl;
+	}
+	return mismatches == 0 ? 0 : 1;
+}
+
+// Print the outcome of one step of a check and return 1 if it failed.
+static int report(const char* step, bool passed)
+{
+	cout << (passed ? "ok\t" : "FAILED\t") << step << endl;
+	return passed ? 0 : 1;
+}
+
+int runShaderCacheCheck()
+{
+	ShaderCache cache("shadercache_check_");
+	int failures = 0;
+
+	// Keys differ with the sources and with the order they are chained in.
+	unsigned long long key = ShaderCache::hash("void main() {}", ShaderCache::hash("#version 120"));
+	unsigned long long otherKey = ShaderCache::hash("#version 120", ShaderCache::hash("void main() {}"));
+	failures += report("hash is FNV-1a", ShaderCache::hash("a") == 0xaf63dc4c8601ec8cULL);
+	failures += report("keys depend on the sources", key != otherKey);
+
+	vector<char> binary, loaded;
+	for (int i = 0; i < 1000; i++)
+		binary.push_back((char)(i * 7));
+	unsigned int format = 0;
+
+	cache.remove(key);
+	cache.remove(otherKey);
+	failures += report("missing entry is a miss", !cache.load(key, format, loaded));
+
+	failures += report("entry is stored", cache.store(key, 0x8741, binary));
+	failures += report("entry is loaded back", cache.load(key, format, loaded) && format == 0x8741 && loaded == binary);
+	failures += report("other key is a miss", !cache.load(otherKey, format, loaded));
+
+	// An entry renamed to another key must not be taken for it.
+	rename(cache.getPath(key).c_str(), cache.getPath(otherKey).c_str());
+	failures += report("entry under a wrong key is a miss", !cache.load(otherKey, format, loaded));
+
+	// Corrupt the binary after its header.
+	cache.store(key, 0x8741, binary);
+	{
+		fstream file(cache.getPath(key).c_str(), ios::in | ios::out | ios::binary);
+		file.seekp(-10, ios::end);
+		file.put('x');
+	}
+	failures += report("corrupt entry is a miss", !cache.load(key, format, loaded));
+
+	// Cut the file short.
+	cache.store(key, 0x8741, binary);
+	{
+		ifstream in(cache.getPath(key).c_str(), ios::binary);
+		string contents((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+		in.close();
+		ofstream out(cache.getPath(key).c_str(), ios::binary | ios::trunc);
+		out.write(contents.data(), contents.size() / 2);
+	}
+	failures += report("truncated entry is a miss", !cache.load(key, format, loaded));
+
+	cache.store(key, 0x8741, binary);
+	cache.remove(key);
+	failures += report("removed entry is a miss", !cache.load(key, format, loaded));
+
+	cache.remove(otherKey);
+	return failures == 0 ? 0 : 1;
+}
+
+// Number of discs (x[i], y[i]) of radius r[i] for which the batch routine and the one of the
+// kernel disagree on intersecting the rectangle with corners (x1, y1) and (x2, y2).
+static int countDiscMismatches(float x1, float y1, float x2, float y2,
+	const vector<float>& x, const vector<float>& y, const vector<float>& r)
+{
+	int n = (int)x.size(), mismatches = 0;
+	vector<unsigned int> mask((n + 31) / 32);
+	checkDiscsRectangleIntersection(x1, y1, x2, y2, x.data(), y.data(), r.data(), n, mask.data());
+	for (int i = 0; i < n; i++)
+		if ((int)((mask[i / 32] >> (i % 32)) & 1) != geometry::checkDiscRectangleIntersection(x1, y1, x2, y2, x[i], y[i], r[i]))
+			mismatches++;
+	return mismatches;
+}
+
+// Number of quadrilaterals, with vertices b[8 * i] to b[8 * i + 7], for which the batch routine and
+// the general one of the kernel disagree on intersecting the quadrilateral with vertices a.
+static int countQuadrilateralMismatches(const float* a, const vector<float>& b)
+{
+	int n = (int)b.size() / 8, mismatches = 0;
+	vector<float> x(4 * n), y(4 * n);
+	QuadrilateralArrays quads;
+	for (int k = 0; k < 4; k++)
+	{
+		for (int i = 0; i < n; i++)
+		{
+			x[k * n + i] = b[8 * i + 2 * k];
+			y[k * n + i] = b[8 * i + 2 * k + 1];
+		}
+		quads.x[k] = &x[k * n];
+		quads.y[k] = &y[k * n];
+	}
+
+	vector<unsigned int> mask((n + 31) / 32);
+	checkQuadrilateralsIntersection(a[0], a[1], a[2], a[3], a[4], a[5], a[6], a[7], quads, n, mask.data());
+	for (int i = 0; i < n; i++)
+	{
+		const float* q = &b[8 * i];
+		if ((int)((mask[i / 32] >> (i % 32)) & 1) != geometry::checkGeneralQuadrilateralsIntersection(a[0], a[1],
+			a[2], a[3], a[4], a[5], a[6], a[7], q[0], q[1], q[2], q[3], q[4], q[5], q[6], q[7]))
+			mismatches++;
+	}
+	return mismatches;
+}
+
+int runIntersectionCheck()
+{
+	srand(1);
+	int failures = 0;
+
+	// Random discs about a rectangle, its corners given either way round. The count is not a
+	// multiple of 4 so that the scalar tail of the batch is taken too.
+	vector<float> x(CHECKED_PRIMITIVES), y(CHECKED_PRIMITIVES), r(CHECKED_PRIMITIVES);
+	for (int i = 0; i < CHECKED_PRIMITIVES; i++)
+	{
+		x[i] = 20.0f * rand() / RAND_MAX - 10.0f;
+		y[i] = 20.0f * rand() / RAND_MAX - 10.0f;
+		r[i] = 4.0f * rand() / RAND_MAX;
+	}
+	failures += report("random discs match the kernel", countDiscMismatches(-3.0, -2.0, 4.0, 5.0, x, y, r) == 0 &&
+		countDiscMismatches(4.0, 5.0, -3.0, -2.0, x, y, r) == 0);
+
+	// Discs centered on every point of a grid with whole radii, among them discs of radius 0, discs
+	// touching a side and discs of radius 5 touching a corner from 3 across and 4 up, against
+	// rectangles of no width or of a single point.
+	x.clear(); y.clear(); r.clear();
+	for (int i = -5; i <= 9; i++)
+		for (int j = -5; j <= 9; j++)
+			for (int k = 0; k <= 5; k++)
+			{
+				x.push_back((float)i);
+				y.push_back((float)j);
+				r.push_back((float)k);
+			}
+	failures += report("discs on a grid match the kernel", countDiscMismatches(0.0, 0.0, 4.0, 4.0, x, y, r) == 0 &&
+		countDiscMismatches(2.0, 4.0, 2.0, 0.0, x, y, r) == 0 && countDiscMismatches(2.0, 2.0, 2.0, 2.0, x, y, r) == 0);
+
+	// Random convex quadrilaterals, mostly apart and mostly overlapping.
+	float a[8];
+	vector<float> b(8 * CHECKED_PRIMITIVES);
+	int mismatches = 0;
+	for (float spread : { 8.0f, 2.0f })
+	{
+		randomConvexQuadrilateral(0.0, 0.0, a);
+		for (int i = 0; i < CHECKED_PRIMITIVES; i++)
+			randomConvexQuadrilateral(spread * (2.0f * rand() / RAND_MAX - 1.0f),
+				spread * (2.0f * rand() / RAND_MAX - 1.0f), &b[8 * i]);
+		mismatches += countQuadrilateralMismatches(a, b);
+	}
+	failures += report("random quadrilaterals match the kernel", mismatches == 0);
+
+	// Quadrilaterals with vertices on a small grid, so that they share vertices, have collinear
+	// or touching sides, or are not convex or collapse to segments and points. The coordinates
+	// are whole so that the batch routine, in plain float, has no rounding error either.
+	const float grid[][8] = {
+		{ 1, 1, 2, 1, 2, 2, 1, 2 }, // Square.
+		{ 0, 0, 3, 1, 1, 1, 1, 3 }, // Not convex.
+		{ 0, 0, 1, 1, 2, 2, 3, 3 }, // Segment.
+		{ 1, 1, 1, 1, 1, 1, 1, 1 }, // Point.
+	};
+	for (float& coordinate : b)
+		coordinate = (float)(rand() % 4);
+	mismatches = 0;
+	for (const float* quad : grid)
+		mismatches += countQuadrilateralMismatches(quad, b);
+	failures += report("quadrilaterals on a grid match the kernel", mismatches == 0);
+
+	return failures == 0 ? 0 : 1;
+}
+
+// Number of pixels that differ between two images of the same size.
+static int countDifferentPixels(SoftwareRenderer& a, SoftwareRenderer& b)
+{
+	int different = 0;
+	for (int y = 0; y < a.getHeight(); y++)
+		for (int x = 0; x < a.getWidth(); x++)
+			if (!equal(a.getPixel(x, y), a.getPixel(x, y) + 3, b.getPixel(x, y))) different++;
+	return different;
+}
+
+int runSoftwareRenderBenchmark()
+{
+	AsteroidField& field = AsteroidField::getInstance();
+
+	srand(1);
+	field.generate();
+
+	// The craft looks down the field from a little way into it, turned to see it at an angle.
+	float x = 0.0, z = -100.0, angle = 20.0;
+
+	int threads = (int)thread::hardware_concurrency();
+	SoftwareRenderer unculled(WINDOW_X, WINDOW_Y, threads), culled(WINDOW_X, WINDOW_Y, threads);
+	SoftwareRenderer serial(WINDOW_X, WINDOW_Y, 1), occluded(WINDOW_X, WINDOW_Y, threads);
+	Scene scene;
+	scene.createMeshes();
+
+	// The first frame draws the left viewport into the cache, which the later ones copy.
+	cout << "culling\tthreads\tprimitives\tms/first frame\tms/frame" << endl;
+	SoftwareRenderer* renderers[4] = { &unculled, &culled, &serial, &occluded };
+	bool isCulled[4] = { false, true, true, true };
+	const char* names[4] = { "off", "frustum", "frustum", "occlusion" };
+	for (int r = 0; r < 4; r++)
+	{
+		scene.upload(*renderers[r]);
+		scene.setOcclusionCulled(renderers[r] == &occluded);
+		chrono::high_resolution_clock::time_point start = chrono::high_resolution_clock::now();
+		scene.draw(*renderers[r], field, x, z, angle, isCulled[r]);
+		chrono::high_resolution_clock::time_point second = chrono::high_resolution_clock::now();
+		for (int frame = 1; frame < BENCH_FRAMES; frame++)
+			scene.draw(*renderers[r], field, x, z, angle, isCulled[r]);
+		chrono::duration<double, milli> first = second - start, rest = chrono::high_resolution_clock::now() - second;
+		cout << names[r] << "\t" << (r == 2 ? 1 : threads) << "\t" << renderers[r]->getPrimitiveCount() << "\t"
+			<< first.count() << "\t" << rest.count() / (BENCH_FRAMES - 1) << endl;
+	}
+
+	unculled.save("software_unculled.ppm");
+	culled.save("software_culled.ppm");
+	occluded.save("software_occluded.ppm");
+
+	// A frame drawn from the cache must look like one drawn afresh.
+	SoftwareRenderer fresh(WINDOW_X, WINDOW_Y, threads);
+	scene.upload(fresh);
+	scene.setOcclusionCulled(false);
+	scene.draw(fresh, field, x, z, angle, true);
+
+	// Culling may only drop asteroids that are out of sight, and the tiles must not depend on
+	// which thread rasterized them. The asteroids are wireframes, so some of those behind others
+	// show through the gaps and occlusion culling changes a few pixels.
+	int cullingDifferences = countDifferentPixels(unculled, culled);
+	int threadDifferences = countDifferentPixels(culled, serial);
+	int occlusionDifferences = countDifferentPixels(culled, occluded);
+	int cacheDifferences = countDifferentPixels(fresh, culled);
+	cout << "pixels changed by culling: " << cullingDifferences << endl;
+	cout << "pixels changed by threading: " << threadDifferences << endl;
+	cout << "pixels changed by occlusion: " << occlusionDifferences << endl;
+	cout << "pixels changed by caching: " << cacheDifferences << endl;
+	return threadDifferences == 0 && cacheDifferences == 0 ? 0 : 1;
+}
+
+int runSubmitBenchmark()
+{
+	AsteroidField& field = AsteroidField::getInstance();
+
+	srand(1);
+	field.generate();
+	int asteroids = 0;
+	for (int i = 0; i < ROWS * COLUMNS; i++)
+		if (field.get(i).getRadius() > 0) asteroids++;
+
+	float x = 0.0, z = -100.0, angle = 20.0;
+	Scene scene;
+	scene.createMeshes();
+
+	cout << "culling\tbatches/frame\titems/frame\tframes/s" << endl;
+	for (int culled = 0; culled < 2; culled++)
+	{
+		NullBackend backend;
+		chrono::high_resolution_clock::time_point start = chrono::high_resolution_clock::now();
+		for (int frame = 0; frame < BENCH_SUBMITTED_FRAMES; frame++)
+			scene.draw(backend, field, x, z, angle, culled != 0);
+		chrono::duration<double> time = chrono::high_resolution_clock::now() - start;
+		cout << (culled ? "on" : "off") << "\t" << backend.getBatchCount() / backend.getFrameCount() << "\t"
+			<< backend.getItemCount() / backend.getFrameCount() << "\t" << (long long)(backend.getFrameCount() / time.count()) << endl;
+	}
+
+	// The stream of a frame: the meshes, then the left viewport with the asteroids, fine, coarse
+	// and impostors, and the craft, and the right one with the divider and the asteroids.
+	RecordingBackend recording;
+	scene.upload(recording);
+	scene.draw(recording, field, x, z, angle, false);
+	const vector<RenderCommand>& commands = recording.getCommands();
+	const RenderCommand::Type expected[] = { RenderCommand::UPLOAD_MESH, RenderCommand::UPLOAD_MESH,
+		RenderCommand::UPLOAD_MESH, RenderCommand::UPLOAD_MESH, RenderCommand::UPLOAD_MESH, RenderCommand::BEGIN_FRAME,
+		RenderCommand::SET_CAMERA, RenderCommand::SUBMIT, RenderCommand::SUBMIT, RenderCommand::SUBMIT,
+		RenderCommand::SUBMIT, RenderCommand::SET_CAMERA, RenderCommand::SUBMIT, RenderCommand::SET_CAMERA,
+		RenderCommand::SUBMIT, RenderCommand::SUBMIT, RenderCommand::SUBMIT, RenderCommand::PRESENT };
+	int count = (int)(sizeof(expected) / sizeof(expected[0]));
+	bool ordered = (int)commands.size() == count;
+	for (int i = 0; ordered && i < count; i++)
+		ordered = commands[i].type == expected[i];
+
+	int failures = 0;
+	failures += report("frame is submitted in order", ordered);
+	failures += report("every asteroid is submitted to both viewports without culling", ordered &&
+		(int)(commands[7].batch.items.size() + commands[8].batch.items.size() + commands[9].batch.items.size()) == asteroids &&
+		(int)(commands[14].batch.items.size() + commands[15].batch.items.size() + commands[16].batch.items.size()) == asteroids);
+	failures += report("craft and divider are one item each", ordered &&
+		commands[10].batch.items.size() == 1 && commands[12].batch.items.size() == 1);
+
+	// Replaying the stream must draw the same image as drawing directly.
+	SoftwareRenderer direct(WINDOW_X / 4, WINDOW_Y / 4), replayed(WINDOW_X / 4, WINDOW_Y / 4);
+	scene.setSize(WINDOW_X / 4, WINDOW_Y / 4);
+	scene.upload(direct);
+	scene.draw(direct, field, x, z, angle, true);
+	recording.clear();
+	scene.upload(recording);
+	scene.draw(recording, field, x, z, angle, true);
+	recording.replay(replayed);
+	failures += report("replayed frame matches the frame drawn directly", countDifferentPixels(direct, replayed) == 0);
+
+	return failures == 0 ? 0 : 1;
+}
+
+int runPackingBenchmark()
+{
+	int failures = 0;
+
+	// Instances within the far plane of the camera, relative to the origin of its grid cell.
+	vector<float> transforms(4 * BENCH_INSTANCES);
+	vector<unsigned char> colors(4 * BENCH_INSTANCES);
+	srand(1);
+	for (int i = 0; i < BENCH_INSTANCES; i++)
+	{
+		for (int k = 0; k < 3; k++)
+			transforms[4 * i + k] = 500.0f * rand() / RAND_MAX - 250.0f;
+		transforms[4 * i + 3] = 360.0f * rand() / RAND_MAX;
+		for (int k = 0; k < 4; k++)
+			colors[4 * i + k] = (unsigned char)(rand() % 256);
+	}
+
+	cout << "instances\tformat\tbytes/instance\tms" << endl;
+	vector<unsigned char> floats, packed;
+	InstanceFormat formats[2] = { INSTANCE_FORMAT_FLOAT, INSTANCE_FORMAT_PACKED };
+	vector<unsigned char>* encoded[2] = { &floats, &packed };
+	for (int f = 0; f < 2; f++)
+	{
+		chrono::high_resolution_clock::time_point start = chrono::high_resolution_clock::now();
+		encodeInstances(&transforms[0], &colors[0], BENCH_INSTANCES, formats[f], *encoded[f]);
+		chrono::duration<double, milli> time = chrono::high_resolution_clock::now() - start;
+		cout << BENCH_INSTANCES << "\t" << (f == 0 ? "float" : "packed") << "\t" << getInstanceSize(formats[f]) << "\t"
+			<< time.count() << endl;
+	}
+
+	// The converters against glm one value at a time.
+	vector<unsigned short> halves(4 * BENCH_INSTANCES), glmHalves(4 * BENCH_INSTANCES);
+	chrono::high_resolution_clock::time_point start = chrono::high_resolution_clock::now();
+	packHalf(&transforms[0], &halves[0], 4 * BENCH_INSTANCES);
+	chrono::high_resolution_clock::time_point middle = chrono::high_resolution_clock::now();
+	for (int i = 0; i < 4 * BENCH_INSTANCES; i++)
+		glmHalves[i] = glm::packHalf1x16(transforms[i]);
+	chrono::duration<double, milli> simd = middle - start, scalar = chrono::high_resolution_clock::now() - middle;
+	cout << "halves packed per us: " << 4 * BENCH_INSTANCES / simd.count() / 1000 << " with SSE2, "
+		<< 4 * BENCH_INSTANCES / scalar.count() / 1000 << " with glm" << endl;
+	failures += report("packed halves match glm", halves == glmHalves);
+
+	// Every 251st float bit pattern, which reaches every exponent, without infinities and NaNs.
+	vector<float> values;
+	for (unsigned long long bits = 0; bits < (1ULL << 32); bits += 251)
+	{
+		unsigned int pattern = (unsigned int)bits;
+		if ((pattern >> 23 & 0xff) == 0xff) continue;
+		float value;
+		memcpy(&value, &pattern, sizeof(value));
+		values.push_back(value);
+	}
+	halves.resize(values.size());
+	packHalf(&values[0], &halves[0], (int)values.size());
+	bool isSame = true;
+	for (size_t i = 0; i < values.size(); i++)
+		isSame = isSame && halves[i] == glm::packHalf1x16(values[i]);
+	failures += report("halves of floats of every magnitude match glm", isSame);
+
+	vector<unsigned short> allHalves(1 << 16);
+	vector<float> unpacked(1 << 16);
+	for (int i = 0; i < (1 << 16); i++)
+		allHalves[i] = (unsigned short)i;
+	unpackHalf(&allHalves[0], &unpacked[0], 1 << 16);
+	isSame = true;
+	for (int i = 0; i < (1 << 16); i++)
+	{
+		float expected = glm::unpackHalf1x16(allHalves[i]);
+		isSame = isSame && memcmp(&expected, &unpacked[i], sizeof(float)) == 0;
+	}
+	failures += report("every half unpacks as with glm", isSame);
+
+	// Normalized values, past both ends of their range.
+	values.resize(1 << 20);
+	for (int i = 0; i < (1 << 20); i++)
+		values[i] = -1.5f + 3.0f * i / (1 << 20);
+	vector<unsigned char> unorms(values.size());
+	vector<short> snorms(values.size());
+	packUnorm8(&values[0], &unorms[0], (int)values.size());
+	packSnorm16(&values[0], &snorms[0], (int)values.size());
+	bool isUnormSame = true, isSnormSame = true;
+	for (size_t i = 0; i < values.size(); i++)
+	{
+		isUnormSame = isUnormSame && unorms[i] == glm::packUnorm1x8(values[i]);
+		isSnormSame = isSnormSame && (unsigned short)snorms[i] == glm::packSnorm1x16(values[i]);
+	}
+	failures += report("unorm8 values match glm", isUnormSame);
+	failures += report("snorm16 values match glm", isSnormSame);
+
+	// What the packed instances lose: halves keep 11 bits, so at most a sixteenth of a unit within
+	// 256 units of the origin.
+	float largestError = 0;
+	unpacked.resize(4 * BENCH_INSTANCES);
+	unpackHalf((const unsigned short*)&packed[0], &unpacked[0], 4 * BENCH_INSTANCES);
+	for (int i = 0; i < 4 * BENCH_INSTANCES; i++)
+		if (i % 4 != 3) largestError = max(largestError, fabs(unpacked[i] - transforms[i]));
+	cout << "largest position error of packed instances: " << largestError << endl;
+	failures += report("packed positions are within a sixteenth of a unit", largestError <= 0.0625f);
+	failures += report("packed colors are the colors", memcmp(&packed[getInstanceColorOffset(INSTANCE_FORMAT_PACKED,
+		BENCH_INSTANCES)], &colors[0], colors.size()) == 0);
+
+	return failures == 0 ? 0 : 1;
+}
+
+// Feed the governor frames times from load, a function of the frame and the level, returning
+// how many times the level changed. The governor starts afresh at level 0.
+template<typename Load>
+static int governFrames(QualityGovernor& governor, Load load)
+{
+	governor.setEnabled(false);
+	governor.setEnabled(true);
+	int changes = 0;
+	for (int frame = 0; frame < BENCH_GOVERNED_FRAMES; frame++)
+		if (governor.addFrame(load(frame, governor.getLevel()))) changes++;
+	return changes;
+}
+
+int runGovernorBenchmark()
+{
+	int failures = 0;
+	QualityGovernor& governor = QualityGovernor::getInstance();
+	double budget = GOVERNOR_BUDGET_MS;
+
+	// Loads the governor must leave alone.
+	int changes = governFrames(governor, [budget](int frame, int level) { return 0.9 * budget; });
+	failures += report("frames within the budget keep the best quality", changes == 0 && governor.getLevel() == 0);
+	changes = governFrames(governor, [budget](int frame, int level) { return frame % 100 == 50 ? 8 * budget : 0.9 * budget; });
+	failures += report("single slow frames change nothing", changes == 0 && governor.getLevel() == 0);
+
+	// Sustained load lowers the quality step by step, and the end of it raises it back.
+	int lowest = 0, lowered = -1, raised = -1;
+	changes = governFrames(governor, [&](int frame, int level) {
+		lowest = max(lowest, level);
+		if (level > 0 && lowered < 0) lowered = frame;
+		if (frame > BENCH_GOVERNED_FRAMES / 2 && level == 0 && raised < 0) raised = frame - BENCH_GOVERNED_FRAMES / 2;
+		return frame < BENCH_GOVERNED_FRAMES / 2 ? 3 * budget : 0.5 * budget;
+	});
+	cout << "sustained load: lowered after " << lowered << " frames to level " << lowest << ", back to level 0 "
+		<< raised << " frames after it ended" << endl;
+	failures += report("sustained load lowers the quality to the cheapest level", lowest == GOVERNOR_LEVELS - 1);
+	failures += report("the quality comes back when the load ends", raised >= 0 && governor.getLevel() == 0);
+
+	// A load that level 0 cannot meet but level 1 can, without leaving room to raise the quality.
+	changes = governFrames(governor, [budget](int frame, int level) { return (level == 0 ? 1.3 : 1.0) * budget; });
+	failures += report("the governor settles without going back and forth", changes == 1 && governor.getLevel() == 1);
+
+	// What each level saves, drawing the culled scene on the software renderer.
+	AsteroidField& field = AsteroidField::getInstance();
+	srand(1);
+	field.generate();
+	float x = 0.0, z = -100.0, angle = 20.0;
+	Scene scene;
+	scene.createMeshes();
+	SoftwareRenderer renderer(WINDOW_X, WINDOW_Y);
+	scene.upload(renderer);
+
+	cout << "level\tdraw distance\tLOD bias\toccluders\tprimitives\tms/frame" << endl;
+	bool isCheaper = true;
+	int lastPrimitives = 0;
+	for (int level = 0; level < GOVERNOR_LEVELS; level++)
+	{
+		const Quality& quality = QualityGovernor::getQuality(level);
+		scene.setQuality(quality);
+		chrono::high_resolution_clock::time_point start = chrono::high_resolution_clock::now();
+		for (int frame = 0; frame < BENCH_FRAMES; frame++)
+			scene.draw(renderer, field, x, z, angle, true);
+		chrono::duration<double, milli> time = chrono::high_resolution_clock::now() - start;
+		int primitives = renderer.getPrimitiveCount();
+		cout << level << "\t" << quality.drawDistance << "\t" << quality.lodBias << "\t" << quality.occluders << "\t"
+			<< primitives << "\t" << time.count() / BENCH_FRAMES << endl;
+		if (level > 0 && primitives >= lastPrimitives) isCheaper = false;
+		lastPrimitives = primitives;
+	}
+	failures += report("each level draws fewer primitives than the one before", isCheaper);
+
+	return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+// Headless benchmarks and checks, run instead of the game when their flag is the first command
+// line argument. Each returns the process exit code.
+
+// --bench-crafts: ships updated per second for growing numbers of crafts and threads.
+int runCraftBenchmark();
+
+// --bench-rays: rays traced per second against the asteroid hierarchy, one at a time and in
+// packets of four.
+int runRayBenchmark();
+
+// --bench-quads: quadrilateral pairs tested per second by the general and the separating-axis
+// intersection routines, for pairs mostly apart, mixed and mostly overlapping.
+int runQuadBenchmark();
+
+// --check-shader-cache: store, reload and invalidate fake program binaries in the shader cache,
+// checking its logic without a GPU. Returns 1 if any step misbehaves.
+int runShaderCacheCheck();
+
+// --check-intersections: compare the batch intersection routines, which test four primitives at
+// a time, with the routines of the kernel on random primitives and on degenerate ones with whole
+// coordinates. Returns 1 if they disagree on any.
+int runIntersectionCheck();
+
+// --render-software: time per frame of the software renderer without culling, with frustum
+// culling and with occlusion culling as well, for the first frame, which fills the cache of the
+// left viewport, and the later ones, which copy it. The images are saved as software_unculled.ppm,
+// software_culled.ppm and software_occluded.ppm. Reports how many pixels culling changes, and
+// returns 1 if rendering on one thread or from the cache gives a different image.
+int runSoftwareRenderBenchmark();
+
+// --bench-submit: frames per second the scene is put together and submitted to a backend that
+// draws nothing, with and without culling. Then records a frame to check what is submitted and
+// that replaying it draws the same image. Returns 1 if a check fails.
+int runSubmitBenchmark();
+
+// --bench-packing: time to encode a million asteroid instances as floats and packed, and halves
+// packed per second with SSE2 and with glm. Checks the converters against glm and the error of
+// the packed instances, returning 1 if a check fails.
+int runPackingBenchmark();
+
+// --bench-governor: feeds the quality governor steady, spiking and sustained loads, checking that
+// it changes the level only when and as far as it should, then times the software renderer at
+// every level. Returns 1 if a check fails.
+int runGovernorBenchmark();
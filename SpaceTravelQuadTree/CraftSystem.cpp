@@ -0,0 +1,189 @@
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+#include "CraftSystem.h"
+#include "AsteroidField.h"
+#include "collisionDetectionRoutines.h"
+
+int CraftSystem::add(float x, float z, float a)
+{
+	xVal.push_back(x);
+	zVal.push_back(z);
+	angle.push_back(a);
+	speed.push_back(0);
+	angSpeed.push_back(0);
+	isCollision.push_back(0);
+	return getCount() - 1;
+}
+
+void CraftSystem::clear()
+{
+	xVal.clear();
+	zVal.clear();
+	angle.clear();
+	speed.clear();
+	angSpeed.clear();
+	isCollision.clear();
+}
+
+void CraftSystem::setInput(int craft, float s, float a)
+{
+	speed[craft] = s;
+	angSpeed[craft] = a;
+}
+
+void CraftSystem::update(int threadCount)
+{
+	int count = getCount();
+	if (threadCount < 1) threadCount = 1;
+	if (threadCount > count) threadCount = count > 0 ? count : 1;
+	if ((int)scratch.size() < threadCount) scratch.resize(threadCount);
+
+	if (threadCount == 1)
+	{
+		updateRange(0, count, scratch[0]);
+		return;
+	}
+
+	// Crafts only read the asteroid field and write their own slots, so contiguous ranges
+	// can be updated in parallel without locking.
+	vector<thread> workers;
+	for (int t = 0; t < threadCount; t++)
+	{
+		int begin = (int)((long long)count * t / threadCount);
+		int end = (int)((long long)count * (t + 1) / threadCount);
+		workers.push_back(thread(&CraftSystem::updateRange, this, begin, end, ref(scratch[t])));
+	}
+	for (thread& worker : workers)
+		worker.join();
+}
+
+void CraftSystem::updateRange(int begin, int end, CraftScratch& scratch)
+{
+	for (int i = begin; i < end; i++)
+	{
+		float tempAngle = angle[i] + angSpeed[i] * 2.0;
+		float tempxVal = xVal[i] + speed[i] * sin(tempAngle * PI / 180.0);
+		float tempzVal = zVal[i] + speed[i] * cos(tempAngle * PI / 180.0);
+
+		// Move the craft along the step only up to the first contact with an asteroid, so that
+		// large steps cannot tunnel through it.
+		float t = asteroidCraftTimeOfImpact(xVal[i], zVal[i], angle[i], tempxVal, tempzVal, tempAngle, scratch);
+		if (t < 0)
+		{
+			isCollision[i] = 0;
+			t = 1;
+		}
+		else
+		{
+			isCollision[i] = 1;
+		}
+
+		xVal[i] += t * (tempxVal - xVal[i]);
+		zVal[i] += t * (tempzVal - zVal[i]);
+		angle[i] += t * (tempAngle - angle[i]);
+
+		// Angle correction.
+		if (angle[i] > 360.0) angle[i] -= 360.0;
+		if (angle[i] < 0.0) angle[i] += 360.0;
+	}
+}
+
+// Function to find the first contact between the cone of the spacecraft and the asteroid at the
+// given index as the center of the base of the craft moves from (x0, 0, z0) to (x1, 0, z1) and its
+// alignment to the -z direction turns from a0 to a1, starting the search at fraction t of the move.
+// Return the fraction of the move at which contact happens, or -1 if there is none.
+static float craftAsteroidTimeOfImpact(float x0, float z0, float a0, float x1, float z1, float a1,
+	int index, float t)
+{
+	Asteroid& asteroid = AsteroidField::getInstance().get(index);
+
+	// No point of the craft moves further than this over the whole move, as the apex is the
+	// point furthest (10) from the center of the base around which the craft turns.
+	float bound = sqrt((x1 - x0)*(x1 - x0) + (z1 - z0)*(z1 - z0)) + 10 * fabs(a1 - a0) * PI / 180.0;
+	if (bound == 0) return -1;
+
+	// Conservative advancement: the craft can safely move on by the fraction of the move that
+	// covers its current distance to the asteroid.
+	const float tolerance = 0.01f;
+	for (int step = 0; step < 32 && t <= 1; step++)
+	{
+		float x = x0 + t * (x1 - x0), z = z0 + t * (z1 - z0), a = a0 + t * (a1 - a0);
+		float distance = pointConeDistance(asteroid.getCenterX(), asteroid.getCenterY(), asteroid.getCenterZ(),
+			x - 10 * sin((PI / 180.0) * a), 0.0, z - 10 * cos((PI / 180.0) * a), x, 0.0, z, 5.0) - asteroid.getRadius();
+
+		if (distance <= tolerance)
+		{
+			// In contact: stop only if the move takes the craft closer, otherwise slide on.
+			float probe = t + tolerance / bound;
+			x = x0 + probe * (x1 - x0), z = z0 + probe * (z1 - z0), a = a0 + probe * (a1 - a0);
+			if (pointConeDistance(asteroid.getCenterX(), asteroid.getCenterY(), asteroid.getCenterZ(),
+				x - 10 * sin((PI / 180.0) * a), 0.0, z - 10 * cos((PI / 180.0) * a), x, 0.0, z, 5.0)
+				- asteroid.getRadius() < distance)
+				return t;
+			distance = tolerance;
+		}
+
+		t += distance / bound;
+	}
+	return t <= 1 ? t : -1;
+}
+
+// Function to find the first contact between the spacecraft and an asteroid as the center of the
+// base of the craft moves from (x0, 0, z0) to (x1, 0, z1) and its alignment to the -z direction
+// turns from a0 to a1. Return the fraction of the move at which contact happens, or -1 if the
+// whole move is free. A bounding sphere swept along a straight line is tested first, and the
+// exact cone is only tested against the asteroids that sphere would hit.
+float asteroidCraftTimeOfImpact(float x0, float z0, float a0, float x1, float z1, float a1,
+	CraftScratch& scratch)
+{
+	AsteroidField& field = AsteroidField::getInstance();
+	vector<int>& candidates = scratch.candidates;
+	vector<float>& centerX = scratch.centerX, &centerY = scratch.centerY, &centerZ = scratch.centerZ;
+	vector<float>& radius = scratch.radius, &times = scratch.times;
+
+	float cx0 = x0 - 5 * sin((PI / 180.0) * a0), cz0 = z0 - 5 * cos((PI / 180.0) * a0);
+	float cx1 = x1 - 5 * sin((PI / 180.0) * a1), cz1 = z1 - 5 * cos((PI / 180.0) * a1);
+
+	// The center of the bounding sphere really turns on an arc, so grow the sphere by the most
+	// the arc strays from the straight line.
+	float r = 7.072 + 5 * (1 - cos((PI / 360.0) * fabs(a1 - a0)));
+
+	// Only the asteroids near the box swept by the bounding sphere can be hit.
+	candidates.clear();
+	field.queryCandidates(min(cx0, cx1) - r, min(cz0, cz1) - r, max(cx0, cx1) + r, max(cz0, cz1) + r,
+		candidates);
+
+	int n = candidates.size();
+	centerX.resize(n); centerY.resize(n); centerZ.resize(n); radius.resize(n); times.resize(n);
+	for (int i = 0; i < n; i++)
+	{
+		Asteroid& asteroid = field.get(candidates[i]);
+		centerX[i] = asteroid.getCenterX();
+		centerY[i] = asteroid.getCenterY();
+		centerZ[i] = asteroid.getCenterZ();
+		radius[i] = asteroid.getRadius();
+	}
+	if (n > 0)
+		sweptSpheresTimeOfImpact(cx0, 0.0, cz0, cx1, 0.0, cz1, r,
+			&centerX[0], &centerY[0], &centerZ[0], &radius[0], n, &times[0]);
+
+	float firstContact = -1;
+	for (int i = 0; i < n; i++)
+	{
+		// A bounding sphere that starts overlapping may still be moving away while the cone
+		// turns into the asteroid, so it is always passed on to the exact test.
+		if (times[i] < 0 && checkSpheresIntersection(cx0, 0.0, cz0, r, centerX[i], centerY[i], centerZ[i], radius[i]))
+			times[i] = 0;
+
+		// The cone cannot touch the asteroid before its bounding sphere does, nor after an
+		// earlier contact that has already been found.
+		if (times[i] < 0 || (firstContact >= 0 && times[i] >= firstContact)) continue;
+
+		float t = craftAsteroidTimeOfImpact(x0, z0, a0, x1, z1, a1, candidates[i], times[i]);
+		if (t >= 0 && (firstContact < 0 || t < firstContact))
+			firstContact = t;
+	}
+	return firstContact;
+}
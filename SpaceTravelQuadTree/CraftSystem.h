@@ -0,0 +1,61 @@
+#pragma once
+
+#include <vector>
+
+using namespace std;
+
+// Scratch arrays used by the collision queries of one worker thread.
+struct CraftScratch
+{
+	vector<int> candidates;
+	vector<float> centerX, centerY, centerZ, radius, times;
+};
+
+// The spacecrafts. State is kept as one array per component so that a whole range of crafts
+// can be moved and collided as a batch, split over several threads, against the shared
+// asteroid field. Craft 0 is the one flown by the player.
+class CraftSystem
+{
+public:
+	// Add a craft with the center of its base at (x, 0, z) aligned at angle a to the -z
+	// direction, and return its index.
+	int add(float x, float z, float a);
+	void clear();
+
+	int getCount() { return (int)xVal.size(); }
+	float getX(int craft) { return xVal[craft]; }
+	float getZ(int craft) { return zVal[craft]; }
+	float getAngle(int craft) { return angle[craft]; }
+	bool isColliding(int craft) { return isCollision[craft] != 0; }
+
+	// Set the input driving a craft on the next update: speed is -1, 0 or 1 units per step
+	// along the craft's axis and angSpeed is -1, 0 or 1 turns of 2 degrees per step.
+	void setInput(int craft, float speed, float angSpeed);
+
+	// Move every craft one step, stopping it at its first contact with an asteroid.
+	void update(int threadCount = 1);
+
+	static CraftSystem& getInstance() {
+		static CraftSystem instance;
+		return instance;
+	}
+
+private:
+	vector<float> xVal, zVal, angle; // Co-ordinates and angles of the crafts.
+	vector<float> speed, angSpeed;
+	vector<char> isCollision; // Is there collision between the craft and an asteroid?
+	vector<CraftScratch> scratch; // One per worker thread.
+
+	void updateRange(int begin, int end, CraftScratch& scratch);
+
+	CraftSystem() {}
+	CraftSystem(CraftSystem const&);
+	void operator=(CraftSystem const&);
+};
+
+// Function to find the first contact between the spacecraft and an asteroid as the center of the
+// base of the craft moves from (x0, 0, z0) to (x1, 0, z1) and its alignment to the -z direction
+// turns from a0 to a1. Return the fraction of the move at which contact happens, or -1 if the
+// whole move is free.
+float asteroidCraftTimeOfImpact(float x0, float z0, float a0, float x1, float z1, float a1,
+	CraftScratch& scratch);
@@ -0,0 +1,138 @@
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#else
+#include <sys/stat.h>
+#include <sys/types.h>
+#endif
+
+#include "FileWatcher.h"
+
+// Split a path into the directory it is in, "." if none, and the file name.
+static void splitPath(const string& path, string& directory, string& name)
+{
+	size_t slash = path.find_last_of("/\\");
+	directory = slash == string::npos ? "." : path.substr(0, slash);
+	name = slash == string::npos ? path : path.substr(slash + 1);
+}
+
+static void addOnce(vector<string>& changed, const string& path)
+{
+	if (find(changed.begin(), changed.end(), path) == changed.end()) changed.push_back(path);
+}
+
+#ifdef __linux__
+
+FileWatcher::FileWatcher()
+{
+	descriptor = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+}
+
+FileWatcher::~FileWatcher()
+{
+	if (descriptor >= 0) close(descriptor);
+}
+
+void FileWatcher::watch(const string& path)
+{
+	paths.push_back(path);
+
+	// Watch the directory rather than the file, whose inode changes when an editor saves by
+	// writing a new file and renaming it over the old one.
+	string directory, name;
+	splitPath(path, directory, name);
+	int watchDescriptor = inotify_add_watch(descriptor, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+	if (watchDescriptor >= 0) directories[watchDescriptor] = directory;
+}
+
+void FileWatcher::waitForChanges(int timeoutMs, vector<string>& changed)
+{
+	if (descriptor < 0)
+	{
+		this_thread::sleep_for(chrono::milliseconds(timeoutMs));
+		return;
+	}
+
+	pollfd events = { descriptor, POLLIN, 0 };
+	if (poll(&events, 1, timeoutMs) <= 0) return;
+	readEvents(changed);
+	while (poll(&events, 1, FILE_WATCHER_SETTLE_MS) > 0) readEvents(changed);
+}
+
+void FileWatcher::readEvents(vector<string>& changed)
+{
+	alignas(inotify_event) char buffer[4096];
+	ssize_t length;
+	while ((length = read(descriptor, buffer, sizeof(buffer))) > 0)
+	{
+		for (char* p = buffer; p < buffer + length; p += sizeof(inotify_event) + ((inotify_event*)p)->len)
+		{
+			const inotify_event* event = (const inotify_event*)p;
+			if (event->len == 0 || directories.count(event->wd) == 0) continue;
+
+			for (const string& path : paths)
+			{
+				string directory, name;
+				splitPath(path, directory, name);
+				if (directory == directories[event->wd] && name == event->name) addOnce(changed, path);
+			}
+		}
+	}
+}
+
+#else
+
+FileWatcher::FileWatcher()
+{
+}
+
+FileWatcher::~FileWatcher()
+{
+}
+
+void FileWatcher::watch(const string& path)
+{
+	paths.push_back(path);
+	times.push_back(getModificationTime(path));
+}
+
+void FileWatcher::waitForChanges(int timeoutMs, vector<string>& changed)
+{
+	this_thread::sleep_for(chrono::milliseconds(timeoutMs));
+	if (!compareTimes(changed)) return;
+
+	// Keep waiting while the files are still being written.
+	do
+	{
+		this_thread::sleep_for(chrono::milliseconds(FILE_WATCHER_SETTLE_MS));
+	} while (compareTimes(changed));
+}
+
+long long FileWatcher::getModificationTime(const string& path)
+{
+	struct stat status;
+	return stat(path.c_str(), &status) == 0 ? (long long)status.st_mtime : -1;
+}
+
+bool FileWatcher::compareTimes(vector<string>& changed)
+{
+	bool any = false;
+	for (size_t i = 0; i < paths.size(); i++)
+	{
+		long long time = getModificationTime(paths[i]);
+		if (time != times[i] && time != -1)
+		{
+			addOnce(changed, paths[i]);
+			any = true;
+		}
+		times[i] = time;
+	}
+	return any;
+}
+
+#endif
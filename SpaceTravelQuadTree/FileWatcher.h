@@ -0,0 +1,47 @@
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+#define FILE_WATCHER_SETTLE_MS 50 // Quiet time after a change before it is reported, so that a
+                                  // save written in several steps is seen once, complete.
+
+// Reports changes to a set of files. On Linux the kernel notifies the watcher through inotify
+// when a file in one of their directories is closed after writing or moved in, which is how
+// editors save; elsewhere the modification times are polled. Files may be missing when watched
+// and show up as changed when they are created.
+class FileWatcher
+{
+public:
+	FileWatcher();
+	~FileWatcher();
+
+	void watch(const string& path);
+
+	// Wait up to timeoutMs for watched files to change and add the paths, as passed to watch, of
+	// those that did to changed. Returns as soon as there are changes.
+	void waitForChanges(int timeoutMs, vector<string>& changed);
+
+private:
+	vector<string> paths;
+
+#ifdef __linux__
+	int descriptor; // inotify instance.
+	map<int, string> directories; // Directory of each inotify watch.
+
+	// Add the paths of the watched files named by the pending events to changed.
+	void readEvents(vector<string>& changed);
+#else
+	vector<long long> times; // Last seen modification time of each path, or -1 if missing.
+
+	static long long getModificationTime(const string& path);
+	// Add the paths whose time changed since the last call to changed. Return whether there were any.
+	bool compareTimes(vector<string>& changed);
+#endif
+
+	FileWatcher(FileWatcher const&);
+	void operator=(FileWatcher const&);
+};
@@ -0,0 +1,231 @@
+#include <cmath>
+#include <glm/gtc/type_ptr.hpp>
+
+#include "GLBackend.h"
+#include "ShaderManager.h"
+
+void GLBackend::start(GLFWwindow* window)
+{
+	this->window = window;
+
+	// initialize the graphics
+	glEnable(GL_DEPTH_TEST);
+	glClearColor(0.0, 0.0, 0.0, 0.0);
+
+	// Create a vertex array object
+	glGenVertexArrays(1, &vao);
+	glBindVertexArray(vao);
+}
+
+void GLBackend::loadShaders(const char* vShaderFile, const char* fShaderFile)
+{
+	program = ShaderManager::getInstance().load(vShaderFile, fShaderFile);
+}
+
+void GLBackend::setShaderProgram(GLuint program)
+{
+	glDeleteProgram(this->program);
+	this->program = program;
+	glUseProgram(program);
+
+	// What is cached was drawn by the old program.
+	isCacheValid = false;
+}
+
+void GLBackend::uploadMesh(MeshId mesh, const glm::vec3* vertices, int count, MeshMode mode,
+	const unsigned short* edges, int edgeCount)
+{
+	encodeMesh(vertices, count, meshFormats[mesh], data, meshScales[mesh]);
+	if (buffers[mesh] == 0) glGenBuffers(1, &buffers[mesh]);
+	glBindBuffer(GL_ARRAY_BUFFER, buffers[mesh]);
+	glBufferData(GL_ARRAY_BUFFER, data.size(), &data[0], GL_STATIC_DRAW);
+
+	edgeCounts[mesh] = edgeCount;
+	if (edgeCount > 0)
+	{
+		if (edgeBuffers[mesh] == 0) glGenBuffers(1, &edgeBuffers[mesh]);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, edgeBuffers[mesh]);
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, 2 * edgeCount * sizeof(unsigned short), edges, GL_STATIC_DRAW);
+	}
+	counts[mesh] = count;
+	modes[mesh] = mode == MESH_TRIANGLE_FAN ? GL_TRIANGLE_FAN : GL_LINE_STRIP;
+}
+
+void GLBackend::beginFrame()
+{
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	glUseProgram(program);
+}
+
+void GLBackend::setCamera(const Viewport& viewport, const glm::mat4& projection, const glm::mat4& view)
+{
+	this->viewport = viewport;
+	glViewport(viewport.x, viewport.y, viewport.width, viewport.height);
+	glMatrixMode(GL_PROJECTION);
+	glLoadMatrixf(glm::value_ptr(projection));
+	glMatrixMode(GL_MODELVIEW);
+	this->view = view;
+}
+
+void GLBackend::submit(const DrawBatch& batch)
+{
+	// Initialize the vertex position attribute from the vertex shader, whose program may have
+	// been reloaded since the last frame.
+	glBindBuffer(GL_ARRAY_BUFFER, buffers[batch.mesh]);
+	GLuint loc = glGetAttribLocation(program, "vPosition");
+	glEnableVertexAttribArray(loc);
+	if (meshFormats[batch.mesh] == MESH_FORMAT_SNORM16)
+		glVertexAttribPointer(loc, 3, GL_SHORT, GL_TRUE, 4 * sizeof(short), 0);
+	else
+		glVertexAttribPointer(loc, 3, GL_FLOAT, GL_FALSE, 0, 0);
+	glUniform1f(glGetUniformLocation(program, "meshScale"), meshScales[batch.mesh]);
+	glUniform1f(glGetUniformLocation(program, "impostor"), batch.isImpostor ? 1.0f : 0.0f);
+
+	// Wireframes are drawn as the lines of the mesh's edges, each once, or failing those by
+	// turning on wireframe mode.
+	bool isEdgeList = batch.wireframe && edgeCounts[batch.mesh] > 0;
+	if (isEdgeList) glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, edgeBuffers[batch.mesh]);
+	else if (batch.wireframe) glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+	glLineWidth((GLfloat)batch.lineWidth);
+
+	// Shaders without the instance attributes draw every item on its own.
+	GLint positionLocation = glGetAttribLocation(program, "iPosition"), colorLocation = glGetAttribLocation(program, "iColor");
+	if (!batch.isInstanced || !drawInstanced(batch, isEdgeList, positionLocation, colorLocation))
+	{
+		glUniform3f(glGetUniformLocation(program, "instanceOrigin"), 0, 0, 0);
+		if (positionLocation >= 0) glVertexAttrib4f(positionLocation, 0, 0, 0, 0);
+		for (const DrawItem& item : batch.items)
+		{
+			glm::mat4 modelview = view * item.model;
+			glLoadMatrixf(glm::value_ptr(modelview));
+			glColor3ubv(item.color);
+			if (colorLocation >= 0) glVertexAttrib4Nub(colorLocation, item.color[0], item.color[1], item.color[2], 255);
+			if (isEdgeList) glDrawElements(GL_LINES, 2 * edgeCounts[batch.mesh], GL_UNSIGNED_SHORT, 0);
+			else glDrawArrays(modes[batch.mesh], 0, counts[batch.mesh]);
+		}
+	}
+
+	// Turn off wireframe mode
+	if (batch.wireframe && !isEdgeList) glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+	glLineWidth(1.0);
+}
+
+// Draw the items of batch as instances of its mesh, or of its edges if isEdgeList, in one call,
+// returning false without OpenGL 3.3.
+bool GLBackend::drawInstanced(const DrawBatch& batch, bool isEdgeList, GLint positionLocation, GLint colorLocation)
+{
+	if (positionLocation < 0 || colorLocation < 0 || !GLEW_VERSION_3_3) return false;
+	int count = (int)batch.items.size();
+	if (count == 0) return true;
+
+	// Positions are kept small, for the precision of halves, by measuring them from the corner of
+	// the grid cell the camera is in.
+	glm::vec3 eye = glm::vec3(glm::inverse(view)[3]);
+	glm::vec3 origin = glm::floor(eye / INSTANCE_CELL_SIZE) * INSTANCE_CELL_SIZE;
+
+	// The model matrix of an item is a translation times a turn about y.
+	instanceTransforms.resize(4 * count);
+	instanceColors.resize(4 * count);
+	for (int i = 0; i < count; i++)
+	{
+		const glm::mat4& model = batch.items[i].model;
+		instanceTransforms[4 * i] = model[3][0] - origin.x;
+		instanceTransforms[4 * i + 1] = model[3][1] - origin.y;
+		instanceTransforms[4 * i + 2] = model[3][2] - origin.z;
+		instanceTransforms[4 * i + 3] = glm::degrees(atan2(model[2][0], model[0][0]));
+		instanceColors[4 * i] = batch.items[i].color[0];
+		instanceColors[4 * i + 1] = batch.items[i].color[1];
+		instanceColors[4 * i + 2] = batch.items[i].color[2];
+		instanceColors[4 * i + 3] = 255;
+	}
+	encodeInstances(&instanceTransforms[0], &instanceColors[0], count, instanceFormat, data);
+
+	if (instanceBuffer == 0) glGenBuffers(1, &instanceBuffer);
+	glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+	glBufferData(GL_ARRAY_BUFFER, data.size(), &data[0], GL_STREAM_DRAW);
+	GLvoid* colorOffset = (GLvoid*)(size_t)getInstanceColorOffset(instanceFormat, count);
+	if (instanceFormat == INSTANCE_FORMAT_PACKED)
+	{
+		glVertexAttribPointer(positionLocation, 4, GL_HALF_FLOAT, GL_FALSE, 0, 0);
+		glVertexAttribPointer(colorLocation, 4, GL_UNSIGNED_BYTE, GL_TRUE, 0, colorOffset);
+	}
+	else
+	{
+		glVertexAttribPointer(positionLocation, 4, GL_FLOAT, GL_FALSE, 0, 0);
+		glVertexAttribPointer(colorLocation, 4, GL_FLOAT, GL_FALSE, 0, colorOffset);
+	}
+	glEnableVertexAttribArray(positionLocation);
+	glEnableVertexAttribArray(colorLocation);
+	glVertexAttribDivisor(positionLocation, 1);
+	glVertexAttribDivisor(colorLocation, 1);
+
+	glLoadMatrixf(glm::value_ptr(view));
+	glUniform3f(glGetUniformLocation(program, "instanceOrigin"), origin.x, origin.y, origin.z);
+	if (isEdgeList) glDrawElementsInstanced(GL_LINES, 2 * edgeCounts[batch.mesh], GL_UNSIGNED_SHORT, 0, count);
+	else glDrawArraysInstanced(modes[batch.mesh], 0, counts[batch.mesh], count);
+
+	// Back to constant attributes for the batches drawn item by item.
+	glVertexAttribDivisor(positionLocation, 0);
+	glVertexAttribDivisor(colorLocation, 0);
+	glDisableVertexAttribArray(positionLocation);
+	glDisableVertexAttribArray(colorLocation);
+	return true;
+}
+
+void GLBackend::beginCache()
+{
+	if (cacheFramebuffer == 0)
+	{
+		glGenFramebuffers(1, &cacheFramebuffer);
+		glGenRenderbuffers(2, cacheRenderbuffers);
+	}
+	glBindFramebuffer(GL_FRAMEBUFFER, cacheFramebuffer);
+
+	// (Re)allocate the target when the viewport changes size.
+	if (cacheWidth != viewport.width || cacheHeight != viewport.height)
+	{
+		cacheWidth = viewport.width;
+		cacheHeight = viewport.height;
+		glBindRenderbuffer(GL_RENDERBUFFER, cacheRenderbuffers[0]);
+		glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, cacheWidth, cacheHeight);
+		glBindRenderbuffer(GL_RENDERBUFFER, cacheRenderbuffers[1]);
+		glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, cacheWidth, cacheHeight);
+		glBindRenderbuffer(GL_RENDERBUFFER, 0);
+		glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, cacheRenderbuffers[0]);
+		glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, cacheRenderbuffers[1]);
+	}
+
+	glViewport(0, 0, cacheWidth, cacheHeight);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	isCacheValid = false;
+}
+
+void GLBackend::endCache(unsigned int key)
+{
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glViewport(viewport.x, viewport.y, viewport.width, viewport.height);
+	cacheKey = key;
+	isCacheValid = true;
+	blitCache();
+}
+
+bool GLBackend::drawCache(unsigned int key)
+{
+	if (!isCacheValid || key != cacheKey || cacheWidth != viewport.width || cacheHeight != viewport.height)
+		return false;
+	blitCache();
+	return true;
+}
+
+void GLBackend::blitCache()
+{
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, cacheFramebuffer);
+	glBlitFramebuffer(0, 0, cacheWidth, cacheHeight, viewport.x, viewport.y, viewport.x + cacheWidth, viewport.y + cacheHeight,
+		GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+}
+
+void GLBackend::present()
+{
+	glfwSwapBuffers(window);
+}
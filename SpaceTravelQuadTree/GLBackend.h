@@ -0,0 +1,69 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <GL/glfw3.h>
+
+#include "RenderBackend.h"
+#include "VertexFormats.h"
+
+// Draws with OpenGL into a GLFW window, through the fixed function matrices and the shader
+// program loaded by loadShaders. Instanced batches are drawn in one call from a buffer of their
+// instances, and each buffer may be stored in a compact format.
+class GLBackend : public RenderBackend
+{
+public:
+	// Set the state every frame starts from. The window's context must be current.
+	void start(GLFWwindow* window);
+
+	void loadShaders(const char* vShaderFile, const char* fShaderFile);
+
+	// Draw with program from now on, deleting the one in use.
+	void setShaderProgram(GLuint program);
+
+	// Store the vertices of mesh in format from its next upload on.
+	void setMeshFormat(MeshId mesh, MeshFormat format) { meshFormats[mesh] = format; }
+
+	// Store the instances of instanced batches in format.
+	void setInstanceFormat(InstanceFormat format) { instanceFormat = format; }
+
+	void uploadMesh(MeshId mesh, const glm::vec3* vertices, int count, MeshMode mode, const unsigned short* edges,
+		int edgeCount) override;
+	void beginFrame() override;
+	void setCamera(const Viewport& viewport, const glm::mat4& projection, const glm::mat4& view) override;
+	void submit(const DrawBatch& batch) override;
+	void beginCache() override;
+	void endCache(unsigned int key) override;
+	bool drawCache(unsigned int key) override;
+	void present() override;
+
+private:
+	GLFWwindow* window = nullptr;
+	GLuint program = 0;
+	GLuint vao = 0;
+	GLuint buffers[MESH_COUNT] = {};
+	int counts[MESH_COUNT] = {};
+	GLenum modes[MESH_COUNT] = {};
+	GLuint edgeBuffers[MESH_COUNT] = {};
+	int edgeCounts[MESH_COUNT] = {};
+	MeshFormat meshFormats[MESH_COUNT] = {};
+	float meshScales[MESH_COUNT] = {};
+	vector<unsigned char> data; // Scratch: what is uploaded to a buffer.
+
+	GLuint instanceBuffer = 0;
+	InstanceFormat instanceFormat = INSTANCE_FORMAT_FLOAT;
+	vector<float> instanceTransforms;
+	vector<unsigned char> instanceColors;
+	glm::mat4 view;
+	Viewport viewport;
+
+	// Offscreen target of the cache, in the formats of the window's buffers so that its depths
+	// can be blitted along with its colors.
+	GLuint cacheFramebuffer = 0;
+	GLuint cacheRenderbuffers[2] = {}; // Color, then depth and stencil.
+	int cacheWidth = 0, cacheHeight = 0;
+	unsigned int cacheKey = 0;
+	bool isCacheValid = false;
+
+	void blitCache();
+	bool drawInstanced(const DrawBatch& batch, bool isEdgeList, GLint positionLocation, GLint colorLocation);
+};
@@ -31,6 +31,11 @@ bool Input::getKeyUp(KeyCode key)
 	return keysUp->find(key) != keysUp->end();
 }
 
+bool Input::isIdle()
+{
+	return keysDown->empty() && keysUp->empty() && keysPressed->empty();
+}
+
 void Input::flush()
 {
 	// persist all keys pressed at this frame.
@@ -79,6 +84,10 @@ KeyCode Input::getKeyCodeFromGLKey(int key)
 		return KEYCODE_UP;
 	case GLFW_KEY_DOWN:
 		return KEYCODE_DOWN;
+	case GLFW_KEY_G:
+		return KEYCODE_G;
+	case GLFW_KEY_O:
+		return KEYCODE_O;
 	default:
 		return KEYCODE_NONE;
 	}
@@ -18,6 +18,9 @@ public:
 	bool getKeyUp(KeyCode key);
 	bool getKey(KeyCode key);
 	void flush();
+
+	// No key is held, or has been pressed or released since the last flush.
+	bool isIdle();
 	void start();
 
 	~Input();
@@ -0,0 +1,113 @@
+#include <cmath>
+
+#include "LooseGrid.h"
+
+void LooseGrid::init(float minX, float minZ, float maxX, float maxZ, float size, float s)
+{
+	originX = minX;
+	originZ = minZ;
+	cellSize = size;
+	slack = s;
+	columns = (int)ceil((maxX - minX) / size);
+	rows = (int)ceil((maxZ - minZ) / size);
+	if (columns < 1) columns = 1;
+	if (rows < 1) rows = 1;
+
+	cells.assign(columns * rows, vector<int>());
+	objectCell.clear();
+	objectSlot.clear();
+	reinsertions = 0;
+}
+
+void LooseGrid::clear()
+{
+	for (vector<int>& cell : cells)
+		cell.clear();
+	objectCell.clear();
+	objectSlot.clear();
+	reinsertions = 0;
+}
+
+int LooseGrid::getColumn(float x)
+{
+	int column = (int)floor((x - originX) / cellSize);
+	if (column < 0) return 0;
+	if (column > columns - 1) return columns - 1;
+	return column;
+}
+
+int LooseGrid::getRow(float z)
+{
+	int row = (int)floor((z - originZ) / cellSize);
+	if (row < 0) return 0;
+	if (row > rows - 1) return rows - 1;
+	return row;
+}
+
+void LooseGrid::add(int object, int cell)
+{
+	objectCell[object] = cell;
+	objectSlot[object] = (int)cells[cell].size();
+	cells[cell].push_back(object);
+}
+
+void LooseGrid::remove(int object)
+{
+	// Swap the last object of the cell into the freed slot.
+	vector<int>& cell = cells[objectCell[object]];
+	int last = cell.back();
+	cell[objectSlot[object]] = last;
+	objectSlot[last] = objectSlot[object];
+	cell.pop_back();
+	objectCell[object] = -1;
+}
+
+void LooseGrid::insert(int object, float x, float z)
+{
+	if (object >= (int)objectCell.size())
+	{
+		objectCell.resize(object + 1, -1);
+		objectSlot.resize(object + 1, -1);
+	}
+	if (objectCell[object] >= 0) remove(object);
+	add(object, getRow(z) * columns + getColumn(x));
+}
+
+void LooseGrid::update(int object, float x, float z, float r)
+{
+	int cell = objectCell[object];
+	int column = cell % columns, row = cell / columns;
+
+	// Border cells reach out to infinity on their outer sides.
+	float minX = column == 0 ? -HUGE_VAL : originX + column * cellSize - slack;
+	float maxX = column == columns - 1 ? HUGE_VAL : originX + (column + 1) * cellSize + slack;
+	float minZ = row == 0 ? -HUGE_VAL : originZ + row * cellSize - slack;
+	float maxZ = row == rows - 1 ? HUGE_VAL : originZ + (row + 1) * cellSize + slack;
+
+	if (x - r >= minX && x + r <= maxX && z - r >= minZ && z + r <= maxZ) return;
+
+	remove(object);
+	add(object, getRow(z) * columns + getColumn(x));
+	reinsertions++;
+}
+
+void LooseGrid::query(float minX, float minZ, float maxX, float maxZ, vector<int>& objects)
+{
+	// Objects stick out of their cell by up to the slack.
+	int columnMin = getColumn(minX - slack), columnMax = getColumn(maxX + slack);
+	int rowMin = getRow(minZ - slack), rowMax = getRow(maxZ + slack);
+
+	for (int row = rowMin; row <= rowMax; row++)
+		for (int column = columnMin; column <= columnMax; column++)
+		{
+			vector<int>& cell = cells[row * columns + column];
+			objects.insert(objects.end(), cell.begin(), cell.end());
+		}
+}
+
+int LooseGrid::takeReinsertions()
+{
+	int count = reinsertions;
+	reinsertions = 0;
+	return count;
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <vector>
+
+using namespace std;
+
+// Loose uniform grid over the xz-plane for moving spheres. Each object is kept in the cell
+// containing its center, and the cell is considered to extend slack units past its edges, so a
+// moving object only has to be re-inserted once its sphere leaves that grown cell. Objects
+// outside the grid are kept in the nearest border cell.
+class LooseGrid
+{
+public:
+	// Cover the rectangle [minX, maxX] x [minZ, maxZ] with square cells of the given size. The
+	// slack must be at least the radius of the largest object.
+	void init(float minX, float minZ, float maxX, float maxZ, float cellSize, float slack);
+	void clear();
+
+	// Put the object in the cell containing its center (x, z), taking it out of any other.
+	void insert(int object, float x, float z);
+
+	// Tell the grid that the object now has its center at (x, z). It is moved to another cell
+	// only if the sphere of radius r has left the loose bounds of its current one.
+	void update(int object, float x, float z, float r);
+
+	// Append every object whose sphere may overlap the box [minX, maxX] x [minZ, maxZ].
+	void query(float minX, float minZ, float maxX, float maxZ, vector<int>& objects);
+
+	// Number of objects moved to another cell since the last call.
+	int takeReinsertions();
+
+private:
+	float originX, originZ, cellSize, slack;
+	int columns, rows;
+	vector<vector<int> > cells;
+	vector<int> objectCell; // Cell of each object, -1 if not inserted.
+	vector<int> objectSlot; // Position of each object in its cell.
+	int reinsertions;
+
+	int getColumn(float x);
+	int getRow(float z);
+	void remove(int object);
+	void add(int object, int cell);
+};
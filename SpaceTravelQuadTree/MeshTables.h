@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cstddef>
+#include <utility>
+
+// Vertex tables of the meshes the renderer builds, generated at compile time for the standard
+// levels of detail so that no trigonometry is done at startup. The generators are constexpr
+// functions of the vertex index, so meshes of other sizes are built at run time with the same
+// formulas and come out identical.
+
+namespace meshTables
+{
+	constexpr double pi = 3.14159265358979323846;
+
+	// Sum of the Taylor series of sin(x) from the term of x^(2k+1) on, accurate to about 1e-15
+	// for |x| <= pi.
+	constexpr double sinSeries(double xSquared, double term, int k, double sum)
+	{
+		return k > 12 ? sum : sinSeries(xSquared, -term * xSquared / ((2 * k + 2) * (2 * k + 3)), k + 1, sum + term);
+	}
+
+	// Sine of an angle in degrees, reduced to [-180, 180] first.
+	constexpr double sinDegrees(double degrees)
+	{
+		return degrees > 180 ? sinDegrees(degrees - 360) :
+			degrees < -180 ? sinDegrees(degrees + 360) :
+			sinSeries((degrees * pi / 180) * (degrees * pi / 180), degrees * pi / 180, 0, 0.0);
+	}
+
+	constexpr double cosDegrees(double degrees)
+	{
+		return sinDegrees(90 - degrees);
+	}
+
+	// Fixed-size table of floats, returned by value from the constexpr generators.
+	template<int N>
+	struct FloatTable
+	{
+		float values[N];
+	};
+
+	// Sphere of unit radius made of quadrilaterals step degrees wide, laid out as by
+	// createSphereMesh of Meshes.cpp: the front and back halves in turn, each band by band from
+	// the pole, four vertices per quadrilateral.
+	constexpr int sphereVertexCount(int step)
+	{
+		return 2 * (90 / step) * (360 / step) * 4;
+	}
+
+	// Coordinate (i % 3 of x, y, z) of vertex i / 3 of the sphere with the given step.
+	constexpr float sphereComponent(int step, int i)
+	{
+		return i % 3 == 2 ?
+			// z: cos(b), negated on the back half.
+			(float)((i / 3 < sphereVertexCount(step) / 2 ? 1 : -1) *
+				cosDegrees(step * ((i / 3 % (sphereVertexCount(step) / 2)) / (4 * (360 / step)) + (i / 3 % 2)))) :
+			// x: sin(a) sin(b), y: cos(a) sin(b).
+			(float)((i % 3 == 0 ? sinDegrees(step * ((i / 3 / 4) % (360 / step) + (i / 3 % 4) / 2)) :
+				cosDegrees(step * ((i / 3 / 4) % (360 / step) + (i / 3 % 4) / 2))) *
+				sinDegrees(step * ((i / 3 % (sphereVertexCount(step) / 2)) / (4 * (360 / step)) + (i / 3 % 2))));
+	}
+
+	// Circle of unit radius split into n segments, as (cos, sin) pairs from angle 0 on.
+	constexpr float ringComponent(int n, int i)
+	{
+		return (float)(i % 2 == 0 ? cosDegrees(360.0 * (i / 2) / n) : sinDegrees(360.0 * (i / 2) / n));
+	}
+
+	template<int Step, size_t... I>
+	constexpr FloatTable<sizeof...(I)> makeSphereTable(std::index_sequence<I...>)
+	{
+		return { { sphereComponent(Step, (int)I)... } };
+	}
+
+	template<int N, size_t... I>
+	constexpr FloatTable<sizeof...(I)> makeRingTable(std::index_sequence<I...>)
+	{
+		return { { ringComponent(N, (int)I)... } };
+	}
+
+	// Baked levels of detail.
+	constexpr FloatTable<3 * sphereVertexCount(30)> sphere30 = makeSphereTable<30>(std::make_index_sequence<3 * sphereVertexCount(30)>());
+	constexpr FloatTable<3 * sphereVertexCount(45)> sphere45 = makeSphereTable<45>(std::make_index_sequence<3 * sphereVertexCount(45)>());
+	constexpr FloatTable<2 * 10> ring10 = makeRingTable<10>(std::make_index_sequence<2 * 10>());
+	constexpr FloatTable<2 * 20> ring20 = makeRingTable<20>(std::make_index_sequence<2 * 20>());
+
+	static_assert(sphere30.values[2] == 1.0f, "first vertex of the front half is at the pole");
+	static_assert(ring10.values[0] == 1.0f && ring10.values[1] == 0.0f, "ring starts at angle 0");
+
+	// Baked table of the sphere with the given step, or nullptr if it has to be built at run time.
+	inline const float* findSphereTable(int step)
+	{
+		return step == 30 ? sphere30.values : step == 45 ? sphere45.values : nullptr;
+	}
+
+	// Baked table of the ring with n segments, or nullptr if it has to be built at run time.
+	inline const float* findRingTable(int n)
+	{
+		return n == 10 ? ring10.values : n == 20 ? ring20.values : nullptr;
+	}
+}
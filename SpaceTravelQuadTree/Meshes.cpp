@@ -0,0 +1,145 @@
+#include <algorithm>
+#include <cmath>
+#include <set>
+#include <utility>
+
+#include "Meshes.h"
+#include "MeshTables.h"
+#include "Renderer.h"
+
+// function obtained from tutorial at:
+// http://www.freemancw.com/2012/06/opengl-cone-function/
+// used in drawing a cone
+glm::vec3 perp(const glm::vec3 &v) {
+	float min = fabs(v.x);
+	glm::vec3 cardinalAxis(1, 0, 0);
+
+	if (fabs(v.y) < min) {
+		min = fabs(v.y);
+		cardinalAxis = glm::vec3(0, 1, 0);
+	}
+
+	if (fabs(v.z) < min) {
+		cardinalAxis = glm::vec3(0, 0, 1);
+	}
+
+	return glm::cross(v, cardinalAxis);
+}
+
+// function derived from tutorial at:
+// http://www.freemancw.com/2012/06/opengl-cone-function/
+void createConeMesh(const glm::vec3 &d, const glm::vec3 &a,
+	const float h, const float rd, const int n, glm::vec3* points) {
+	glm::vec3 c;
+	c.x = a.x + (-d.x * h);
+	c.y = a.y + (-d.y * h);
+	c.z = a.z + (-d.z * h);
+	glm::vec3 e0 = perp(d);
+	glm::vec3 e1 = glm::cross(e0, d);
+
+	// cosines and sines around the directrix, baked for the usual segment counts
+	const float* ring = meshTables::findRingTable(n);
+
+	// draw cone top
+	points[0] = a;
+
+	// calculate points around directrix
+	int i;
+	for (i = 1; i < n + 1; ++i) {
+		float cosine = ring ? ring[2 * (i - 1)] : meshTables::ringComponent(n, 2 * (i - 1));
+		float sine = ring ? ring[2 * (i - 1) + 1] : meshTables::ringComponent(n, 2 * (i - 1) + 1);
+		points[i] = c + (((e0 * cosine) + (e1 * sine)) * rd);
+	}
+
+	points[i] = points[1];
+
+	// original tutorial has cone bottom
+	// not necessary when cone is a spaceship!
+}
+
+// function derived from tutorial at:
+// http://www.swiftless.com/tutorials/opengl/sphere.html
+void createSphereMesh(const float R, const float H, const float K, const float Z, const int step, glm::vec3* points) {
+	// unit sphere, baked at compile time for the usual steps
+	const float* unit = meshTables::findSphereTable(step);
+	int count = meshTables::sphereVertexCount(step);
+
+	// the front half and then the back half, each a band of quadrilaterals at a time
+	for (int n = 0; n < count; n++) {
+		float x = unit ? unit[3 * n] : meshTables::sphereComponent(step, 3 * n);
+		float y = unit ? unit[3 * n + 1] : meshTables::sphereComponent(step, 3 * n + 1);
+		float z = unit ? unit[3 * n + 2] : meshTables::sphereComponent(step, 3 * n + 2);
+		points[n].x = R * x - H;
+		points[n].y = R * y + K;
+		points[n].z = R * z - Z;
+	}
+}
+
+void createCraftMesh(glm::vec3* points)
+{
+	// create the cone for a spaceship
+	glm::vec3 direction(0, 1, 0);
+	glm::vec3 apex(0, 10, 0);
+	createConeMesh(direction, apex, 10, 5, 10, points);
+}
+
+void createDividerMesh(glm::vec3* points)
+{
+	// create the line for the middle of the screen
+	points[0] = glm::vec3(0, -5, -6);
+	points[1] = glm::vec3(0, 5, -6);
+}
+
+void createAsteroidMesh(glm::vec3* points)
+{
+	createSphereMesh(SPHERE_SIZE, 0, 0, 0, SPHERE_STEP, points);
+}
+
+void createCoarseAsteroidMesh(glm::vec3* points)
+{
+	createSphereMesh(SPHERE_SIZE, 0, 0, 0, COARSE_SPHERE_STEP, points);
+}
+
+// the square around the outline of an asteroid, counterclockwise
+void createImpostorMesh(glm::vec3* points)
+{
+	points[0] = glm::vec3(-SPHERE_SIZE, -SPHERE_SIZE, 0);
+	points[1] = glm::vec3(SPHERE_SIZE, -SPHERE_SIZE, 0);
+	points[2] = glm::vec3(SPHERE_SIZE, SPHERE_SIZE, 0);
+	points[3] = glm::vec3(-SPHERE_SIZE, SPHERE_SIZE, 0);
+}
+
+void createEdgeList(const glm::vec3* points, int count, MeshMode mode, vector<unsigned short>& edges)
+{
+	// The first index of each place.
+	vector<int> welded(count);
+	for (int i = 0; i < count; i++)
+	{
+		welded[i] = i;
+		for (int j = 0; j < i; j++)
+			if (points[j] == points[i]) { welded[i] = j; break; }
+	}
+
+	edges.clear();
+	set<pair<int, int>> seen;
+	auto add = [&](int a, int b) {
+		a = welded[a];
+		b = welded[b];
+		if (a == b || !seen.insert(make_pair(min(a, b), max(a, b))).second) return;
+		edges.push_back((unsigned short)a);
+		edges.push_back((unsigned short)b);
+	};
+
+	if (mode == MESH_LINE_STRIP)
+	{
+		for (int i = 0; i + 1 < count; i++)
+			add(i, i + 1);
+		return;
+	}
+	for (int i = 1; i + 1 < count; i++)
+	{
+		add(0, i);
+		add(i, i + 1);
+		add(i + 1, 0);
+	}
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <vector>
+
+#include "RenderBackend.h"
+
+using namespace std;
+
+// Builders of the meshes every renderer draws, each writing its vertices into an array the
+// caller provides. The divider is drawn as a line strip, the other meshes as triangle fans from
+// their first vertex.
+
+// Vector perpendicular to v.
+glm::vec3 perp(const glm::vec3 &v);
+
+// Cone with apex a, axis d (of unit length), height h and base radius rd, made of n triangles:
+// the apex followed by n + 1 points around the base, the last one repeating the first.
+void createConeMesh(const glm::vec3 &d, const glm::vec3 &a,
+	const float h, const float rd, const int n, glm::vec3* points);
+
+// Sphere of radius R centered at (-H, K, -Z), made of quadrilaterals step degrees wide:
+// meshTables::sphereVertexCount(step) vertices.
+void createSphereMesh(const float R, const float H, const float K, const float Z, const int step, glm::vec3* points);
+
+// The meshes of the game, of CONE_VERTEX_COUNT, LINE_VERTEX_COUNT, SPHERE_VERTEX_COUNT,
+// COARSE_SPHERE_VERTEX_COUNT and IMPOSTOR_VERTEX_COUNT vertices.
+void createCraftMesh(glm::vec3* points);
+void createDividerMesh(glm::vec3* points);
+void createAsteroidMesh(glm::vec3* points);
+void createCoarseAsteroidMesh(glm::vec3* points);
+void createImpostorMesh(glm::vec3* points);
+
+// The lines of count points made into primitives by mode, as pairs of indices into points: every
+// edge of the primitives once, however many primitives share it. Points at the same place count
+// as one, and edges that shrink to a point are left out.
+void createEdgeList(const glm::vec3* points, int count, MeshMode mode, vector<unsigned short>& edges);
@@ -0,0 +1,25 @@
+#pragma once
+
+#include "RenderBackend.h"
+
+// Backend that draws nothing, to time what it costs to put a frame together and submit it
+// apart from any drawing. It only counts what it is given.
+class NullBackend : public RenderBackend
+{
+public:
+	void uploadMesh(MeshId mesh, const glm::vec3* vertices, int count, MeshMode mode, const unsigned short* edges,
+		int edgeCount) override {}
+	void beginFrame() override {}
+	void setCamera(const Viewport& viewport, const glm::mat4& projection, const glm::mat4& view) override {}
+	void submit(const DrawBatch& batch) override { batches++; items += batch.items.size(); }
+	void present() override { frames++; }
+
+	long long getFrameCount() { return frames; }
+	long long getBatchCount() { return batches; }
+	long long getItemCount() { return items; }
+
+private:
+	long long frames = 0;
+	long long batches = 0;
+	long long items = 0;
+};
@@ -0,0 +1,159 @@
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <xmmintrin.h>
+
+#include "OcclusionCuller.h"
+#include "AsteroidField.h"
+
+static_assert(OCCLUSION_SIZE >> (OCCLUSION_LEVELS - 1) == 1, "the pyramid goes down to one pixel");
+static_assert(OCCLUSION_SIZE % 4 == 0, "rows are drawn four pixels at a time");
+
+void OcclusionCuller::cull(AsteroidField& field, const glm::mat4& projection, const glm::mat4& view, vector<int>& ids)
+{
+	occluded = 0;
+	if (ids.size() < 2) return;
+	clear();
+
+	// Distance to the near plane of a glFrustum projection.
+	float nearPlane = projection[3][2] / (projection[2][2] - 1.0f);
+	float scale = 0.5f * OCCLUSION_SIZE * min(fabs(projection[0][0]), fabs(projection[1][1]));
+
+	int n = (int)ids.size();
+	depths.resize(n);
+	order.resize(n);
+	for (int i = 0; i < n; i++)
+	{
+		Asteroid& asteroid = field.get(ids[i]);
+		depths[i] = -(view * glm::vec4(asteroid.getCenterX(), asteroid.getCenterY(), asteroid.getCenterZ(), 1.0f)).z;
+		order[i] = i;
+	}
+
+	// Draw the nearest asteroids as occluders.
+	int drawn = min(n, occluders);
+	nth_element(order.begin(), order.begin() + drawn - 1, order.end(),
+		[this](int a, int b) { return depths[a] < depths[b]; });
+	for (int k = 0; k < drawn; k++)
+	{
+		int i = order[k];
+		Asteroid& asteroid = field.get(ids[i]);
+
+		// The mesh is drawn at SPHERE_SIZE, so a larger radius would cover more than the sphere.
+		float radius = min(asteroid.getRadius(), (float)SPHERE_SIZE);
+		if (depths[i] - radius <= nearPlane) continue;
+
+		glm::vec4 clip = projection * view * glm::vec4(asteroid.getCenterX(), asteroid.getCenterY(), asteroid.getCenterZ(), 1.0f);
+		drawOccluder((clip.x / clip.w + 1) * 0.5f * OCCLUSION_SIZE, (clip.y / clip.w + 1) * 0.5f * OCCLUSION_SIZE,
+			radius * scale / depths[i], depths[i]);
+	}
+	buildPyramid();
+
+	// Test the bounding box of every asteroid, keeping those not hidden.
+	glm::mat4 viewProjection = projection * view;
+	int kept = 0;
+	for (int i = 0; i < n; i++)
+	{
+		Asteroid& asteroid = field.get(ids[i]);
+
+		// The mesh is drawn at SPHERE_SIZE whatever the radius of the asteroid.
+		float bound = max(asteroid.getRadius(), (float)SPHERE_SIZE);
+		bool hidden = depths[i] - bound > nearPlane;
+		if (hidden)
+		{
+			float x0 = FLT_MAX, y0 = FLT_MAX, x1 = -FLT_MAX, y1 = -FLT_MAX;
+			for (int corner = 0; corner < 8; corner++)
+			{
+				glm::vec4 clip = viewProjection * glm::vec4(asteroid.getCenterX() + (corner & 1 ? bound : -bound),
+					asteroid.getCenterY() + (corner & 2 ? bound : -bound), asteroid.getCenterZ() + (corner & 4 ? bound : -bound), 1.0f);
+				if (clip.w <= nearPlane) { hidden = false; break; } // The box reaches behind the near plane.
+				float x = (clip.x / clip.w + 1) * 0.5f * OCCLUSION_SIZE, y = (clip.y / clip.w + 1) * 0.5f * OCCLUSION_SIZE;
+				x0 = min(x0, x); x1 = max(x1, x);
+				y0 = min(y0, y); y1 = max(y1, y);
+			}
+			hidden = hidden && isOccluded(x0, y0, x1, y1, depths[i] - bound);
+		}
+
+		if (hidden) occluded++;
+		else ids[kept++] = ids[i];
+	}
+	ids.resize(kept);
+}
+
+void OcclusionCuller::clear()
+{
+	if (pyramid.empty())
+	{
+		int size = 0;
+		for (int level = 0; level < OCCLUSION_LEVELS; level++)
+			size += (OCCLUSION_SIZE >> level) * (OCCLUSION_SIZE >> level);
+		pyramid.resize(size);
+		levels[0] = &pyramid[0];
+		for (int level = 1; level < OCCLUSION_LEVELS; level++)
+			levels[level] = levels[level - 1] + (OCCLUSION_SIZE >> (level - 1)) * (OCCLUSION_SIZE >> (level - 1));
+	}
+	fill(levels[0], levels[0] + OCCLUSION_SIZE * OCCLUSION_SIZE, FLT_MAX);
+}
+
+// Draw the disc of pixels whose centers are within radius of (x, y), keeping the nearer depth.
+void OcclusionCuller::drawOccluder(float x, float y, float radius, float depth)
+{
+	int first = max(0, (int)ceil(y - radius - 0.5f)), last = min(OCCLUSION_SIZE - 1, (int)floor(y + radius - 0.5f));
+	__m128 depth4 = _mm_set1_ps(depth);
+	__m128 lanes = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f);
+
+	for (int row = first; row <= last; row++)
+	{
+		float dy = row + 0.5f - y;
+		float half = sqrt(max(0.0f, radius * radius - dy * dy));
+		int x0 = max(0, (int)ceil(x - half - 0.5f)), x1 = min(OCCLUSION_SIZE - 1, (int)floor(x + half - 0.5f));
+		if (x0 > x1) continue;
+
+		float* line = levels[0] + row * OCCLUSION_SIZE;
+		__m128 start = _mm_set1_ps((float)x0), end = _mm_set1_ps((float)x1);
+		for (int px = x0 & ~3; px <= x1; px += 4)
+		{
+			__m128 index = _mm_add_ps(_mm_set1_ps((float)px), lanes);
+			__m128 inside = _mm_and_ps(_mm_cmpge_ps(index, start), _mm_cmple_ps(index, end));
+			__m128 old = _mm_loadu_ps(line + px);
+			__m128 nearer = _mm_min_ps(old, depth4);
+			_mm_storeu_ps(line + px, _mm_or_ps(_mm_and_ps(inside, nearer), _mm_andnot_ps(inside, old)));
+		}
+	}
+}
+
+// Each texel of a level keeps the farthest of the four below it.
+void OcclusionCuller::buildPyramid()
+{
+	for (int level = 1; level < OCCLUSION_LEVELS; level++)
+	{
+		int size = OCCLUSION_SIZE >> level;
+		const float* below = levels[level - 1];
+		float* texels = levels[level];
+		for (int y = 0; y < size; y++)
+			for (int x = 0; x < size; x++)
+			{
+				const float* quad = below + 2 * y * 2 * size + 2 * x;
+				texels[y * size + x] = max(max(quad[0], quad[1]), max(quad[2 * size], quad[2 * size + 1]));
+			}
+	}
+}
+
+// Whether everything in the pixel rectangle [x0, x1] x [y0, y1] is farther than depth from the
+// occluders, tested on the level where the rectangle covers at most two texels each way.
+bool OcclusionCuller::isOccluded(float x0, float y0, float x1, float y1, float depth)
+{
+	// Left to frustum culling.
+	if (x1 < 0 || y1 < 0 || x0 >= OCCLUSION_SIZE || y0 >= OCCLUSION_SIZE) return false;
+
+	int ix0 = max(0, (int)floor(x0)), iy0 = max(0, (int)floor(y0));
+	int ix1 = min(OCCLUSION_SIZE - 1, (int)floor(x1)), iy1 = min(OCCLUSION_SIZE - 1, (int)floor(y1));
+	int level = 0;
+	while ((ix1 >> level) - (ix0 >> level) > 1 || (iy1 >> level) - (iy0 >> level) > 1)
+		level++;
+
+	int size = OCCLUSION_SIZE >> level;
+	for (int y = iy0 >> level; y <= iy1 >> level; y++)
+		for (int x = ix0 >> level; x <= ix1 >> level; x++)
+			if (levels[level][y * size + x] >= depth) return false;
+	return true;
+}
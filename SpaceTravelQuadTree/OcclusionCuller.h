@@ -0,0 +1,45 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <vector>
+
+using namespace std;
+
+class AsteroidField;
+
+#define OCCLUSION_SIZE 128 // Pixels on a side of the depth buffer, a power of two.
+#define OCCLUSION_LEVELS 8 // Levels of the depth pyramid, down to one pixel.
+#define OCCLUSION_OCCLUDERS 64 // Nearest asteroids drawn into the depth buffer by default.
+
+// Culls asteroids hidden behind nearer ones, on the CPU. The nearest asteroids are drawn as
+// occluders into a small buffer of view distances, four pixels at a time with SSE, each as the
+// disc of its sphere facing the camera at the depth of its center: a shape and depth the solid
+// sphere is sure to cover. A pyramid whose texels keep the farthest distance below them is built
+// from the buffer, and an asteroid is occluded when its bounding box is nearer nowhere than the
+// few texels of the level that cover it.
+class OcclusionCuller
+{
+public:
+	// Remove from ids the asteroids of field that are hidden behind others, as seen through
+	// projection and view.
+	void cull(AsteroidField& field, const glm::mat4& projection, const glm::mat4& view, vector<int>& ids);
+
+	// How many of the nearest asteroids are drawn as occluders. More hide more, at a cost.
+	void setOccluderCount(int count) { occluders = count; }
+
+	// Asteroids removed by the last cull.
+	int getOccludedCount() { return occluded; }
+
+private:
+	float* levels[OCCLUSION_LEVELS]; // Into pyramid, level 0 first.
+	vector<float> pyramid;
+	vector<float> depths; // Scratch: view distance of each candidate.
+	vector<int> order;
+	int occluders = OCCLUSION_OCCLUDERS;
+	int occluded = 0;
+
+	void clear();
+	void drawOccluder(float x, float y, float radius, float depth);
+	void buildPyramid();
+	bool isOccluded(float x0, float y0, float x1, float y1, float depth);
+};
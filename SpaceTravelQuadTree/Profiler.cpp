@@ -0,0 +1,40 @@
+#include <iostream>
+
+#include "Profiler.h"
+
+void Profiler::setCounter(const string& name, double value)
+{
+	counters[name].frame = value;
+}
+
+void Profiler::addCounter(const string& name, double value)
+{
+	counters[name].frame += value;
+}
+
+double Profiler::getAverage(const string& name)
+{
+	map<string, Counter>::iterator it = counters.find(name);
+	if (it == counters.end() || frames == 0) return 0;
+	return it->second.total / frames;
+}
+
+void Profiler::endFrame()
+{
+	for (auto& entry : counters)
+	{
+		entry.second.total += entry.second.frame;
+		entry.second.frame = 0;
+	}
+	frames++;
+
+	if (frames < PROFILER_REPORT_FRAMES) return;
+
+	cout << "Profile over " << frames << " frames (average per frame):" << endl;
+	for (auto& entry : counters)
+	{
+		cout << "  " << entry.first << ": " << entry.second.total / frames << endl;
+		entry.second.total = 0;
+	}
+	frames = 0;
+}
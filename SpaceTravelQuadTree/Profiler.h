@@ -0,0 +1,40 @@
+#pragma once
+
+#include <map>
+#include <string>
+
+using namespace std;
+
+#define PROFILER_REPORT_FRAMES 300 // Frames between two reports to the console.
+
+// Per-frame counters. Systems set or add to named counters while a frame runs, and every
+// PROFILER_REPORT_FRAMES frames the average value per frame of each counter is printed.
+class Profiler
+{
+public:
+	void setCounter(const string& name, double value);
+	void addCounter(const string& name, double value);
+
+	// Average per frame of a counter over the frames reported so far in this period.
+	double getAverage(const string& name);
+
+	void endFrame();
+
+	static Profiler& getInstance() {
+		static Profiler instance;
+		return instance;
+	}
+
+private:
+	struct Counter
+	{
+		double frame; // Value in the current frame.
+		double total; // Sum over the frames of the current period.
+	};
+	map<string, Counter> counters;
+	int frames = 0;
+
+	Profiler() {}
+	Profiler(Profiler const&);
+	void operator=(Profiler const&);
+};
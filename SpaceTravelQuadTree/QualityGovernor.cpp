@@ -0,0 +1,70 @@
+#include <iostream>
+
+#include "QualityGovernor.h"
+#include "OcclusionCuller.h"
+#include "Profiler.h"
+
+// From the best quality to the cheapest.
+static const Quality levels[GOVERNOR_LEVELS] = {
+	{ 250.0f, 0.0f, OCCLUSION_OCCLUDERS, false },
+	{ 250.0f, 1.0f, OCCLUSION_OCCLUDERS, false },
+	{ 200.0f, 1.5f, 2 * OCCLUSION_OCCLUDERS, true },
+	{ 150.0f, 2.0f, 2 * OCCLUSION_OCCLUDERS, true },
+	{ 100.0f, 3.0f, 4 * OCCLUSION_OCCLUDERS, true },
+};
+
+const Quality& QualityGovernor::getQuality(int level)
+{
+	return levels[level];
+}
+
+bool QualityGovernor::addFrame(double milliseconds)
+{
+	if (count == GOVERNOR_FRAMES) total -= times[next];
+	else count++;
+	times[next] = milliseconds;
+	total += milliseconds;
+	next = (next + 1) % GOVERNOR_FRAMES;
+	framesSinceChange++;
+
+	double average = total / count;
+	Profiler& profiler = Profiler::getInstance();
+	profiler.setCounter("frame ms", milliseconds);
+	profiler.setCounter("quality level", level);
+	if (!enabled || count < GOVERNOR_FRAMES) return false;
+
+	framesUnder = average < GOVERNOR_RAISE * budget ? framesUnder + 1 : 0;
+	int change = 0;
+	if (framesSinceChange >= GOVERNOR_HOLD)
+	{
+		if (average > GOVERNOR_LOWER * budget && level + 1 < GOVERNOR_LEVELS) change = 1;
+		else if (framesUnder >= GOVERNOR_HOLD && level > 0) change = -1;
+	}
+	if (change == 0) return false;
+
+	level += change;
+	framesSinceChange = 0;
+	framesUnder = 0;
+	profiler.setCounter("quality level", level);
+	profiler.addCounter("quality changes", 1);
+	const Quality& quality = levels[level];
+	cout << "Quality " << (change > 0 ? "lowered" : "raised") << " to level " << level << " at " << average
+		<< " ms a frame: draw distance " << quality.drawDistance << ", LOD bias " << quality.lodBias << ", "
+		<< quality.occluders << " occluders" << (quality.isOcclusionForced ? ", occlusion culling forced" : "") << endl;
+	return true;
+}
+
+void QualityGovernor::setEnabled(bool isEnabled)
+{
+	enabled = isEnabled;
+	if (!enabled) level = 0;
+	reset();
+}
+
+void QualityGovernor::reset()
+{
+	count = next = 0;
+	total = 0;
+	framesSinceChange = 0;
+	framesUnder = 0;
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#define GOVERNOR_BUDGET_MS 16.7 // Frame time the governor aims for by default: 60 frames a second.
+#define GOVERNOR_FRAMES 30 // Recent frames whose times are averaged.
+#define GOVERNOR_LOWER 1.15 // Quality is lowered when the average is over this times the budget,
+#define GOVERNOR_RAISE 0.7 // and raised when it has stayed under this times the budget
+#define GOVERNOR_HOLD 120 // for this many frames. A change also waits this long after the last one.
+#define GOVERNOR_LEVELS 5
+
+// What the scene draws at one level of quality.
+struct Quality
+{
+	float drawDistance; // Far plane of the cameras.
+	float lodBias; // Asteroids are drawn with the coarse mesh beyond drawDistance / 2^lodBias.
+	int occluders; // Nearest asteroids drawn into the depth buffer of occlusion culling,
+	bool isOcclusionForced; // which is done, if this is set, even when it is turned off.
+};
+
+// Holds the frame time to a budget by trading quality for it. The average of the recent frame
+// times picks the level of quality, level 0 being the best, one step at a time. Lowering the
+// quality takes an average well over the budget, so that a single slow frame does nothing, and
+// raising it takes one well under the budget for a long while, so that the governor does not go
+// back and forth between two levels.
+class QualityGovernor
+{
+public:
+	// Record how long the last frame took, returning whether the level changed.
+	bool addFrame(double milliseconds);
+
+	// Stay at level 0 while disabled.
+	void setEnabled(bool isEnabled);
+	bool isEnabled() { return enabled; }
+
+	void setBudget(double milliseconds) { budget = milliseconds; }
+
+	int getLevel() { return level; }
+	const Quality& getQuality() { return getQuality(level); }
+	static const Quality& getQuality(int level);
+
+	// Forget the frames recorded so far, as after a pause in which none were drawn.
+	void reset();
+
+	static QualityGovernor& getInstance() {
+		static QualityGovernor instance;
+		return instance;
+	}
+
+private:
+	double times[GOVERNOR_FRAMES];
+	int count = 0, next = 0;
+	double total = 0;
+	double budget = GOVERNOR_BUDGET_MS;
+	bool enabled = true;
+	int level = 0;
+	int framesSinceChange = 0;
+	int framesUnder = 0; // Frames in a row the average was low enough to raise the quality.
+
+	QualityGovernor() {}
+	QualityGovernor(QualityGovernor const&);
+	void operator=(QualityGovernor const&);
+};
@@ -0,0 +1,71 @@
+#include "RecordingBackend.h"
+
+void RecordingBackend::uploadMesh(MeshId mesh, const glm::vec3* vertices, int count, MeshMode mode,
+	const unsigned short* edges, int edgeCount)
+{
+	RenderCommand command;
+	command.type = RenderCommand::UPLOAD_MESH;
+	command.mesh = mesh;
+	command.mode = mode;
+	command.vertices.assign(vertices, vertices + count);
+	command.edges.assign(edges, edges + 2 * edgeCount);
+	commands.push_back(command);
+}
+
+void RecordingBackend::beginFrame()
+{
+	RenderCommand command;
+	command.type = RenderCommand::BEGIN_FRAME;
+	commands.push_back(command);
+}
+
+void RecordingBackend::setCamera(const Viewport& viewport, const glm::mat4& projection, const glm::mat4& view)
+{
+	RenderCommand command;
+	command.type = RenderCommand::SET_CAMERA;
+	command.viewport = viewport;
+	command.projection = projection;
+	command.view = view;
+	commands.push_back(command);
+}
+
+void RecordingBackend::submit(const DrawBatch& batch)
+{
+	RenderCommand command;
+	command.type = RenderCommand::SUBMIT;
+	command.batch = batch;
+	commands.push_back(command);
+}
+
+void RecordingBackend::present()
+{
+	RenderCommand command;
+	command.type = RenderCommand::PRESENT;
+	commands.push_back(command);
+}
+
+void RecordingBackend::replay(RenderBackend& backend)
+{
+	for (const RenderCommand& command : commands)
+	{
+		switch (command.type)
+		{
+		case RenderCommand::UPLOAD_MESH:
+			backend.uploadMesh(command.mesh, &command.vertices[0], (int)command.vertices.size(), command.mode,
+				command.edges.empty() ? nullptr : &command.edges[0], (int)command.edges.size() / 2);
+			break;
+		case RenderCommand::BEGIN_FRAME:
+			backend.beginFrame();
+			break;
+		case RenderCommand::SET_CAMERA:
+			backend.setCamera(command.viewport, command.projection, command.view);
+			break;
+		case RenderCommand::SUBMIT:
+			backend.submit(command.batch);
+			break;
+		case RenderCommand::PRESENT:
+			backend.present();
+			break;
+		}
+	}
+}
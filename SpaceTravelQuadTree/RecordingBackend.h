@@ -0,0 +1,49 @@
+#pragma once
+
+#include <vector>
+
+#include "RenderBackend.h"
+
+using namespace std;
+
+// A call made to a backend, with copies of its arguments. Only the members of its type are set.
+struct RenderCommand
+{
+	enum Type { UPLOAD_MESH, BEGIN_FRAME, SET_CAMERA, SUBMIT, PRESENT };
+	Type type;
+
+	// UPLOAD_MESH
+	MeshId mesh;
+	MeshMode mode;
+	vector<glm::vec3> vertices;
+	vector<unsigned short> edges; // Two indices an edge.
+
+	// SET_CAMERA
+	Viewport viewport;
+	glm::mat4 projection, view;
+
+	// SUBMIT
+	DrawBatch batch;
+};
+
+// Backend that keeps the commands it is given, so that tests can check what the game submits
+// and the stream can be replayed to another backend later.
+class RecordingBackend : public RenderBackend
+{
+public:
+	void uploadMesh(MeshId mesh, const glm::vec3* vertices, int count, MeshMode mode, const unsigned short* edges,
+		int edgeCount) override;
+	void beginFrame() override;
+	void setCamera(const Viewport& viewport, const glm::mat4& projection, const glm::mat4& view) override;
+	void submit(const DrawBatch& batch) override;
+	void present() override;
+
+	const vector<RenderCommand>& getCommands() { return commands; }
+	void clear() { commands.clear(); }
+
+	// Make the recorded calls, in order, on backend.
+	void replay(RenderBackend& backend);
+
+private:
+	vector<RenderCommand> commands;
+};
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <vector>
+
+using namespace std;
+
+// Meshes of the game, uploaded once to each backend.
+enum MeshId { MESH_CRAFT, MESH_DIVIDER, MESH_ASTEROID, MESH_COARSE_ASTEROID, MESH_IMPOSTOR, MESH_COUNT };
+
+// How the vertices of a mesh make primitives, as the OpenGL modes of the same names.
+enum MeshMode { MESH_TRIANGLE_FAN, MESH_LINE_STRIP };
+
+// Region of the window drawn into, in pixels from the bottom left corner.
+struct Viewport
+{
+	int x, y, width, height;
+};
+
+// One copy of a mesh: where it is and what color it is drawn in.
+struct DrawItem
+{
+	glm::mat4 model;
+	unsigned char color[3];
+};
+
+// Copies of a mesh drawn with the same state.
+struct DrawBatch
+{
+	MeshId mesh;
+	bool wireframe; // Draw the edges of triangles only, as the GL_LINE polygon mode.
+	int lineWidth;
+	bool isInstanced; // The items only move the mesh and turn it about y, as asteroids do, so they
+	                  // may be drawn in one instanced call.
+	bool isImpostor; // The mesh is a quad in the xy plane centered on the origin, which is turned to
+	                 // face the camera and drawn as the circle inscribed in it, shaded as a sphere.
+	vector<DrawItem> items;
+};
+
+// What the game needs from a graphics API to draw a frame. Scene decides what is in the frame
+// and submits it through this interface, so that the same frame can go to OpenGL, to the
+// software renderer, or nowhere at all to time the submission alone.
+class RenderBackend
+{
+public:
+	virtual ~RenderBackend() {}
+
+	// Create the buffers of a mesh and upload its vertices, replacing any earlier upload. edges are
+	// edgeCount pairs of indices of vertices, each edge of the mesh's primitives once, which
+	// wireframe batches are drawn as instead of the outlines of the primitives.
+	virtual void uploadMesh(MeshId mesh, const glm::vec3* vertices, int count, MeshMode mode, const unsigned short* edges,
+		int edgeCount) = 0;
+
+	// Start a frame by clearing the color and depth buffers.
+	virtual void beginFrame() = 0;
+
+	// Draw into viewport through the given camera until the next call.
+	virtual void setCamera(const Viewport& viewport, const glm::mat4& projection, const glm::mat4& view) = 0;
+
+	virtual void submit(const DrawBatch& batch) = 0;
+
+	// Cache of a viewport whose content seldom changes. What is submitted between beginCache and
+	// endCache is drawn into the cache, starting clear, and kept under key; endCache and drawCache
+	// then copy its colors and depths into the current viewport, where more may be drawn over
+	// them. drawCache returns false, drawing nothing, unless the cache holds key for a viewport
+	// of the current size. Backends without a cache draw straight into the viewport instead.
+	virtual void beginCache() {}
+	virtual void endCache(unsigned int key) {}
+	virtual bool drawCache(unsigned int key) { return false; }
+
+	// Finish the frame and show it.
+	virtual void present() = 0;
+};
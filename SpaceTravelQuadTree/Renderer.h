@@ -7,12 +7,17 @@
 #include <vector>
 
 #include "Asteroid.h"
+#include "GLBackend.h"
+#include "Scene.h"
 
 using namespace std;
 
+class AsteroidField;
+
 #pragma comment ( lib, "opengl32.lib" )
 #pragma comment ( lib, "glew32.lib" )
 #pragma comment ( lib, "glfw3.lib" )
+#pragma comment ( lib, "legacy_stdio_definitions.lib" ) // glfw3.lib was built against the pre-2015 CRT.
 
 #define ROWS 100  // Number of rows of asteroids.
 #define COLUMNS 100 // Number of columns of asteroids.
@@ -26,26 +31,49 @@ using namespace std;
 // fixed number of vertices for cone and sphere
 #define CONE_VERTEX_COUNT 12
 #define LINE_VERTEX_COUNT 2
-#define SPHERE_VERTEX_COUNT 288 // moved to Asteroids.h because asteroids draw themselves
+#define SPHERE_VERTEX_COUNT 288
+#define SPHERE_STEP 30 // Degrees spanned by each quadrilateral of the sphere mesh.
+#define COARSE_SPHERE_VERTEX_COUNT 128
+#define COARSE_SPHERE_STEP 45 // Same for the mesh of distant asteroids at lowered quality.
+#define IMPOSTOR_VERTEX_COUNT 4
 
 #define SPHERE_SIZE 5.0f
 
+#define VERTEX_SHADER_FILE "vshader.glsl"
+#define FRAGMENT_SHADER_FILE "fshader.glsl"
+
 #define PI 3.14159265
 
+#define IDLE_WAIT_MS 50 // Time an idle game sleeps before looking for events and other changes.
+
+// The game's window, drawn into through a GLBackend. What is drawn is up to the Scene.
 class Renderer
 {
 public:
 	int start();
 	GLFWwindow* getWindow();
-	void draw(Asteroid** asteroids, float x, float z, float angle);
-	void drawSphere(float x, float y, float z, unsigned char* color);
+	void draw(AsteroidField& field, float x, float z, float angle, bool isFrustumCulled);
+
+	// Draw with program from now on, deleting the one in use.
+	void setShaderProgram(GLuint program);
 
 	bool isDisposed();
 
+	// Whether the window was resized or uncovered since the last call, and must be drawn again
+	// even if nothing in it changed.
+	bool takeRedraw();
+
+	// Sleep for IDLE_WAIT_MS, then process the events that came meanwhile. Input is not noticed
+	// before the sleep ends, so it can take up to IDLE_WAIT_MS longer to act on. For frames that
+	// draw nothing.
+	void waitEvents();
+
+	// Build the meshes, which needs no graphics context, then upload them and load the shaders
+	// once the window is up.
+	void createMeshes();
 	void createBuffers();
-	void createLine();
-	void createCone();
-	void createSphere();
+
+	Scene& getScene() { return scene; }
 
 	~Renderer();
 	static Renderer& getInstance() {
@@ -54,38 +82,17 @@ public:
 	}
 private:
 	GLFWwindow* window;
+	GLBackend backend;
+	Scene scene;
+	bool isRedrawNeeded = true;
 
-	// window size
-	int width;
-	int height;
-
-	int cone_index = 0;
-	int line_index = cone_index + CONE_VERTEX_COUNT;
-	int sphere_index = line_index + LINE_VERTEX_COUNT;
-
-	void createConeMesh(const glm::vec3 &d, const glm::vec3 &a,
-		const float h, const float rd, const int n, int offset);
-	void createSphereMesh(const float R, const float H, const float K, const float Z, int offset);
-	glm::vec3 perp(const glm::vec3 &v);
-
-	// shader stuff
-	glm::vec3 points[CONE_VERTEX_COUNT + LINE_VERTEX_COUNT + SPHERE_VERTEX_COUNT*ROWS*COLUMNS]; // addition of all rows/cols for asteroid vertices + spaceship vertices + line vertices  
-	GLuint  myShaderProgram;
-	GLuint	myBuffer;
-	char* readShaderSource(const char* shaderFile);
-	GLuint initShaders(const char* vShaderFile, const char* fShaderFile);
-
-	void lookAt(
-		float eyex,		float eyey,		float eyez, 
-		float centerx,	float centery,	float centerz,
-		float upx,		float upy,		float upz);
 	void resize(int w, int h);
 
 	// Static callbacks
 	static void _resizeCallback(GLFWwindow* window, int w, int h);
+	static void _refreshCallback(GLFWwindow* window);
 
 	Renderer() {}
 	Renderer(Renderer& const);
 	void operator=(Renderer& const);
 };
-
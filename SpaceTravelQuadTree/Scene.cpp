@@ -0,0 +1,210 @@
+#include <algorithm>
+#include <cmath>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "Scene.h"
+#include "AsteroidField.h"
+#include "Meshes.h"
+#include "MeshTables.h"
+#include "Profiler.h"
+#include "Renderer.h"
+
+static_assert(SPHERE_VERTEX_COUNT == meshTables::sphereVertexCount(SPHERE_STEP), "sphere vertex count matches its step");
+static_assert(COARSE_SPHERE_VERTEX_COUNT == meshTables::sphereVertexCount(COARSE_SPHERE_STEP),
+	"coarse sphere vertex count matches its step");
+
+#define IMPOSTOR_RADIUS 4.0f // Asteroids whose radius would come out fewer pixels than this times
+                             // (1 + lodBias)^2 are drawn as impostors.
+
+Scene::Scene()
+{
+	quality = QualityGovernor::getQuality(0);
+	setSize(WINDOW_X, WINDOW_Y);
+
+	asteroids.mesh = MESH_ASTEROID;
+	asteroids.wireframe = true;
+	asteroids.lineWidth = 1;
+	asteroids.isInstanced = true;
+	asteroids.isImpostor = false;
+	coarseAsteroids = asteroids;
+	coarseAsteroids.mesh = MESH_COARSE_ASTEROID;
+	impostors = asteroids;
+	impostors.mesh = MESH_IMPOSTOR;
+	impostors.wireframe = false;
+	impostors.isImpostor = true;
+	craft.mesh = MESH_CRAFT;
+	craft.wireframe = true;
+	craft.lineWidth = 1;
+	craft.isInstanced = false;
+	craft.isImpostor = false;
+	divider.mesh = MESH_DIVIDER;
+	divider.wireframe = false;
+	divider.lineWidth = 2;
+	divider.isInstanced = false;
+	divider.isImpostor = false;
+}
+
+void Scene::createMeshes()
+{
+	meshes[MESH_CRAFT].resize(CONE_VERTEX_COUNT);
+	meshes[MESH_DIVIDER].resize(LINE_VERTEX_COUNT);
+	meshes[MESH_ASTEROID].resize(SPHERE_VERTEX_COUNT);
+	meshes[MESH_COARSE_ASTEROID].resize(COARSE_SPHERE_VERTEX_COUNT);
+	meshes[MESH_IMPOSTOR].resize(IMPOSTOR_VERTEX_COUNT);
+	createCraftMesh(&meshes[MESH_CRAFT][0]);
+	createDividerMesh(&meshes[MESH_DIVIDER][0]);
+	createAsteroidMesh(&meshes[MESH_ASTEROID][0]);
+	createCoarseAsteroidMesh(&meshes[MESH_COARSE_ASTEROID][0]);
+	createImpostorMesh(&meshes[MESH_IMPOSTOR][0]);
+	createEdgeList(&meshes[MESH_CRAFT][0], CONE_VERTEX_COUNT, MESH_TRIANGLE_FAN, edges[MESH_CRAFT]);
+	createEdgeList(&meshes[MESH_DIVIDER][0], LINE_VERTEX_COUNT, MESH_LINE_STRIP, edges[MESH_DIVIDER]);
+	createEdgeList(&meshes[MESH_ASTEROID][0], SPHERE_VERTEX_COUNT, MESH_TRIANGLE_FAN, edges[MESH_ASTEROID]);
+	createEdgeList(&meshes[MESH_COARSE_ASTEROID][0], COARSE_SPHERE_VERTEX_COUNT, MESH_TRIANGLE_FAN,
+		edges[MESH_COARSE_ASTEROID]);
+	createEdgeList(&meshes[MESH_IMPOSTOR][0], IMPOSTOR_VERTEX_COUNT, MESH_TRIANGLE_FAN, edges[MESH_IMPOSTOR]);
+}
+
+void Scene::upload(RenderBackend& backend)
+{
+	backend.uploadMesh(MESH_CRAFT, &meshes[MESH_CRAFT][0], CONE_VERTEX_COUNT, MESH_TRIANGLE_FAN,
+		&edges[MESH_CRAFT][0], (int)edges[MESH_CRAFT].size() / 2);
+	backend.uploadMesh(MESH_DIVIDER, &meshes[MESH_DIVIDER][0], LINE_VERTEX_COUNT, MESH_LINE_STRIP,
+		&edges[MESH_DIVIDER][0], (int)edges[MESH_DIVIDER].size() / 2);
+	backend.uploadMesh(MESH_ASTEROID, &meshes[MESH_ASTEROID][0], SPHERE_VERTEX_COUNT, MESH_TRIANGLE_FAN,
+		&edges[MESH_ASTEROID][0], (int)edges[MESH_ASTEROID].size() / 2);
+	backend.uploadMesh(MESH_COARSE_ASTEROID, &meshes[MESH_COARSE_ASTEROID][0], COARSE_SPHERE_VERTEX_COUNT, MESH_TRIANGLE_FAN,
+		&edges[MESH_COARSE_ASTEROID][0], (int)edges[MESH_COARSE_ASTEROID].size() / 2);
+	backend.uploadMesh(MESH_IMPOSTOR, &meshes[MESH_IMPOSTOR][0], IMPOSTOR_VERTEX_COUNT, MESH_TRIANGLE_FAN,
+		&edges[MESH_IMPOSTOR][0], (int)edges[MESH_IMPOSTOR].size() / 2);
+}
+
+void Scene::setSize(int width, int height)
+{
+	this->width = width;
+	this->height = height;
+	projection = glm::frustum(-5.0f, 5.0f, -5.0f, 5.0f, 5.0f, quality.drawDistance);
+}
+
+void Scene::setQuality(const Quality& quality)
+{
+	this->quality = quality;
+	setSize(width, height);
+	occlusion.setOccluderCount(quality.occluders);
+	isQualityChanged = true;
+}
+
+void Scene::draw(RenderBackend& backend, AsteroidField& field, float x, float z, float angle, bool isFrustumCulled)
+{
+	backend.beginFrame();
+
+	// Begin left viewport, from a fixed camera.
+	Viewport left = { 0, 0, width / 2, height };
+	glm::mat4 view = glm::lookAt(glm::vec3(0.0, 10.0, 20.0), glm::vec3(0.0, 0.0, 0.0), glm::vec3(0.0, 1.0, 0.0));
+	backend.setCamera(left, projection, view);
+
+	// The camera is fixed, so while the field stands still its asteroids are drawn once into the
+	// backend's cache and copied from there, and only the craft is drawn over them.
+	if (field.isMoving())
+		drawAsteroids(backend, field, view, isFrustumCulled, leftVisibility);
+	else
+	{
+		bool isOccluded = isOcclusionCulled || quality.isOcclusionForced;
+		unsigned int key = field.getRevision() << 2 | (isFrustumCulled ? 1 : 0) << 1 | (isOccluded ? 1 : 0);
+		if (isQualityChanged || !backend.drawCache(key))
+		{
+			backend.beginCache();
+			drawAsteroids(backend, field, view, isFrustumCulled, leftVisibility);
+			backend.endCache(key);
+			isQualityChanged = false;
+			Profiler::getInstance().addCounter("left viewport redraws", 1);
+		}
+	}
+
+	// off is white spaceship and on it red
+	craft.items.resize(1);
+	DrawItem& ship = craft.items[0];
+	ship.color[0] = 255;
+	ship.color[1] = ship.color[2] = isFrustumCulled ? 0 : 255;
+
+	// spacecraft moves and so we translate/rotate according to the movement
+	ship.model = glm::translate(glm::mat4(1.0f), glm::vec3(x, 0, z));
+	ship.model = glm::rotate(ship.model, glm::radians(angle), glm::vec3(0.0, 1.0, 0.0));
+	ship.model = glm::rotate(ship.model, glm::radians(-90.0f), glm::vec3(1.0, 0.0, 0.0)); // To make the spacecraft point down the $z$-axis initially.
+	backend.submit(craft);
+	// End left viewport.
+
+	// Begin right viewport. The line in the middle separating the two viewports is drawn
+	// before the camera is placed.
+	Viewport right = { width / 2, 0, width / 2, height };
+	backend.setCamera(right, projection, glm::mat4(1.0f));
+
+	divider.items.resize(1);
+	divider.items[0].model = glm::translate(glm::mat4(1.0f), glm::vec3(-6, 0, 0));
+	divider.items[0].color[0] = divider.items[0].color[1] = divider.items[0].color[2] = 255;
+	backend.submit(divider);
+
+	// Locate the camera at the tip of the cone and pointing in the direction of the cone.
+	float s = (float)sin((PI / 180.0) * angle), c = (float)cos((PI / 180.0) * angle);
+	view = glm::lookAt(glm::vec3(x - 10 * s, 0.0, z - 10 * c), glm::vec3(x - 11 * s, 0.0, z - 11 * c),
+		glm::vec3(0.0, 1.0, 0.0));
+	backend.setCamera(right, projection, view);
+
+	drawAsteroids(backend, field, view, isFrustumCulled, rightVisibility);
+	// End right viewport.
+
+	backend.present();
+}
+
+// Submit all the asteroids of the field or, with frustum culling, only the ones cache finds in
+// the frustum of the current camera and, with occlusion culling, not hidden by others. Those
+// farther from the camera than the LOD bias allows are drawn with the coarse mesh, and those that
+// would come out small as impostors.
+void Scene::drawAsteroids(RenderBackend& backend, AsteroidField& field, const glm::mat4& view, bool isFrustumCulled,
+	VisibilityCache& cache)
+{
+	visible.clear();
+	if (isFrustumCulled)
+	{
+		cache.query(field, projection * view, visible);
+		if (isOcclusionCulled || quality.isOcclusionForced)
+		{
+			occlusion.cull(field, projection, view, visible);
+			Profiler::getInstance().addCounter("asteroids occluded", (double)occlusion.getOccludedCount());
+		}
+		Profiler::getInstance().addCounter("asteroids drawn", (double)visible.size());
+	}
+	else
+		for (int i = 0; i < ROWS * COLUMNS; i++)
+			visible.push_back(i);
+
+	// At bias 0 only asteroids wholly beyond the far plane, which are not drawn, get the coarse mesh.
+	float coarseDepth = quality.drawDistance / exp2(quality.lodBias);
+	// In an 800 pixel high viewport an asteroid at the far plane of the best quality is 8 pixels in
+	// radius, so that level has no impostors, and the lower ones have them from 125, 80, 56 and 31
+	// units on.
+	float impostorDepth = SPHERE_SIZE * projection[1][1] * 0.5f * height /
+		(IMPOSTOR_RADIUS * (1.0f + quality.lodBias) * (1.0f + quality.lodBias));
+	asteroids.items.clear();
+	coarseAsteroids.items.clear();
+	impostors.items.clear();
+	for (int index : visible)
+	{
+		Asteroid& asteroid = field.get(index);
+		if (asteroid.getRadius() <= 0) continue; // If asteroid does not exist.
+
+		DrawItem item;
+		item.model = glm::translate(glm::mat4(1.0f), glm::vec3(asteroid.getCenterX(), asteroid.getCenterY(), asteroid.getCenterZ()));
+		item.model = glm::rotate(item.model, glm::radians(asteroid.getSpin()), glm::vec3(0.0, 1.0, 0.0));
+		copy(asteroid.getColor(), asteroid.getColor() + 3, item.color);
+		float depth = -(view[0][2] * asteroid.getCenterX() + view[1][2] * asteroid.getCenterY() + view[2][2] * asteroid.getCenterZ() + view[3][2]);
+		// An impostor keeps the depth of its center, so one reaching past the far plane would be
+		// dropped whole rather than cut; the mesh is clipped there instead.
+		if (depth > impostorDepth && depth + SPHERE_SIZE < quality.drawDistance) impostors.items.push_back(item);
+		else (depth - SPHERE_SIZE > coarseDepth ? coarseAsteroids : asteroids).items.push_back(item);
+	}
+	Profiler::getInstance().addCounter("asteroids coarse", (double)coarseAsteroids.items.size());
+	Profiler::getInstance().addCounter("asteroid impostors", (double)impostors.items.size());
+	backend.submit(asteroids);
+	backend.submit(coarseAsteroids);
+	backend.submit(impostors);
+}
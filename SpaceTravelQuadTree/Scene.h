@@ -0,0 +1,60 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <vector>
+
+#include "OcclusionCuller.h"
+#include "QualityGovernor.h"
+#include "RenderBackend.h"
+#include "VisibilityCache.h"
+
+using namespace std;
+
+class AsteroidField;
+
+// The frame of the game, independent of how it is drawn: the field from a fixed camera in the
+// left viewport with the craft, and from the craft in the right viewport, the two separated by
+// a line. With frustum culling only the asteroids found in each camera's frustum, by the
+// hierarchy or from the camera's last frame, are submitted. Occlusion culling then leaves out
+// those hidden behind nearer ones. The asteroids of the left viewport are kept in the backend's
+// cache while the field stands still.
+// How far the cameras see and which asteroids get the coarse mesh are set by the quality, and
+// asteroids that would come out small are drawn as impostors.
+class Scene
+{
+public:
+	Scene();
+
+	// Build the vertices of the meshes. Needs no graphics context.
+	void createMeshes();
+
+	// Upload the meshes built by createMeshes to backend.
+	void upload(RenderBackend& backend);
+
+	// Size of the window the frame is drawn into.
+	void setSize(int width, int height);
+
+	void draw(RenderBackend& backend, AsteroidField& field, float x, float z, float angle, bool isFrustumCulled);
+
+	// Whether the asteroids left by frustum culling are also culled by occlusion.
+	void setOcclusionCulled(bool isOcclusionCulled) { this->isOcclusionCulled = isOcclusionCulled; }
+
+	void setQuality(const Quality& quality);
+
+private:
+	vector<glm::vec3> meshes[MESH_COUNT];
+	vector<unsigned short> edges[MESH_COUNT]; // Pairs of indices into meshes.
+	int width, height;
+	glm::mat4 projection;
+	Quality quality;
+	bool isQualityChanged = false; // Since the left viewport was cached.
+
+	vector<int> visible;
+	VisibilityCache leftVisibility, rightVisibility;
+	OcclusionCuller occlusion;
+	bool isOcclusionCulled = false;
+	DrawBatch asteroids, coarseAsteroids, impostors, craft, divider;
+
+	void drawAsteroids(RenderBackend& backend, AsteroidField& field, const glm::mat4& view, bool isFrustumCulled,
+		VisibilityCache& cache);
+};
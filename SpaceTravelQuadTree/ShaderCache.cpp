@@ -0,0 +1,71 @@
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+#include "ShaderCache.h"
+
+// Layout of the start of a cache file, followed by length bytes of binary.
+struct ShaderCacheHeader
+{
+	char magic[4]; // "SPCB"
+	unsigned int version;
+	unsigned long long key;
+	unsigned long long checksum; // Hash of the binary.
+	unsigned int format;
+	unsigned int length;
+};
+
+unsigned long long ShaderCache::hash(const string& text, unsigned long long hash)
+{
+	for (unsigned char c : text)
+	{
+		hash ^= c;
+		hash *= 1099511628211ULL;
+	}
+	return hash;
+}
+
+string ShaderCache::getPath(unsigned long long key)
+{
+	ostringstream path;
+	path << prefix << hex << key << ".bin";
+	return path.str();
+}
+
+bool ShaderCache::load(unsigned long long key, unsigned int& format, vector<char>& binary)
+{
+	ifstream file(getPath(key).c_str(), ios::binary);
+	if (!file) return false;
+
+	ShaderCacheHeader header;
+	if (!file.read((char*)&header, sizeof(header))) return false;
+	if (string(header.magic, 4) != "SPCB" || header.version != SHADER_CACHE_VERSION || header.key != key ||
+		header.length == 0)
+		return false;
+
+	binary.resize(header.length);
+	if (!file.read(&binary[0], header.length)) return false;
+	if (hash(string(binary.begin(), binary.end())) != header.checksum) return false;
+
+	format = header.format;
+	return true;
+}
+
+bool ShaderCache::store(unsigned long long key, unsigned int format, const vector<char>& binary)
+{
+	if (binary.empty()) return false;
+
+	ShaderCacheHeader header = { { 'S', 'P', 'C', 'B' }, SHADER_CACHE_VERSION, key,
+		hash(string(binary.begin(), binary.end())), format, (unsigned int)binary.size() };
+
+	ofstream file(getPath(key).c_str(), ios::binary | ios::trunc);
+	if (!file) return false;
+	file.write((const char*)&header, sizeof(header));
+	file.write(&binary[0], binary.size());
+	return (bool)file;
+}
+
+void ShaderCache::remove(unsigned long long key)
+{
+	std::remove(getPath(key).c_str());
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+using namespace std;
+
+#define SHADER_CACHE_VERSION 1 // Bumped whenever the layout of cache files changes.
+
+// On-disk cache of linked shader program binaries, independent of OpenGL. Each program is
+// stored in its own file named after a key that hashes everything the binary depends on: the
+// shader sources and the driver that produced it. Files are checked on load, so a truncated,
+// corrupt or foreign file is a miss rather than a bad program.
+class ShaderCache
+{
+public:
+	// Cache files are named <prefix><key in hex>.bin.
+	explicit ShaderCache(const string& prefix) : prefix(prefix) {}
+
+	// 64-bit FNV-1a hash of text, continuing from hash to chain several texts.
+	static unsigned long long hash(const string& text, unsigned long long hash = 14695981039346656037ULL);
+
+	string getPath(unsigned long long key);
+
+	// Read the binary of the program with the given key and the driver format it is in. Return
+	// false if there is no valid entry for the key.
+	bool load(unsigned long long key, unsigned int& format, vector<char>& binary);
+
+	// Write the binary of the program with the given key, replacing any previous entry.
+	bool store(unsigned long long key, unsigned int format, const vector<char>& binary);
+
+	// Delete the entry of the given key, e.g., because the driver rejected its binary.
+	void remove(unsigned long long key);
+
+private:
+	string prefix;
+};
@@ -0,0 +1,185 @@
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+#include "ShaderManager.h"
+
+// Read a whole file into source, returning false if it cannot be opened.
+static bool readShaderSource(const char* shaderFile, string& source)
+{
+	ifstream file(shaderFile, ios::binary);
+	if (!file) return false;
+	ostringstream text;
+	text << file.rdbuf();
+	source = text.str();
+	return true;
+}
+
+GLuint ShaderManager::load(const char* vShaderFile, const char* fShaderFile)
+{
+	GLuint program = tryLoad(vShaderFile, fShaderFile);
+	if (program == 0) exit(EXIT_FAILURE);
+
+	glUseProgram(program);
+	return program;
+}
+
+GLuint ShaderManager::tryLoad(const char* vShaderFile, const char* fShaderFile)
+{
+	string vSource, fSource;
+	if (!readShaderSource(vShaderFile, vSource))
+	{
+		cerr << "Failed to read " << vShaderFile << endl;
+		return 0;
+	}
+	if (!readShaderSource(fShaderFile, fSource))
+	{
+		cerr << "Failed to read " << fShaderFile << endl;
+		return 0;
+	}
+
+	GLuint program = 0;
+	unsigned long long key = 0;
+	bool binarySupported = isBinarySupported();
+	if (binarySupported)
+	{
+		key = getKey(vSource, fSource);
+		program = loadBinary(key);
+	}
+
+	cached = program != 0;
+	if (!cached)
+	{
+		program = compile(vShaderFile, vSource, fShaderFile, fSource);
+		if (program != 0 && binarySupported) storeBinary(key, program);
+	}
+
+	return program;
+}
+
+bool ShaderManager::isBinarySupported()
+{
+	// Some drivers expose the extension but no binary format.
+	if (!GLEW_ARB_get_program_binary) return false;
+	GLint formats = 0;
+	glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+	return formats > 0;
+}
+
+unsigned long long ShaderManager::getKey(const string& vSource, const string& fSource)
+{
+	// A binary is only valid for the driver that made it, so it is part of the key.
+	unsigned long long key = ShaderCache::hash(vSource);
+	key = ShaderCache::hash(string(1, '\0') + fSource, key);
+	const GLenum driver[] = { GL_VENDOR, GL_RENDERER, GL_VERSION };
+	for (GLenum name : driver)
+	{
+		const char* value = (const char*)glGetString(name);
+		key = ShaderCache::hash(string(1, '\0') + (value ? value : ""), key);
+	}
+	return key;
+}
+
+GLuint ShaderManager::loadBinary(unsigned long long key)
+{
+	unsigned int format;
+	vector<char> binary;
+	if (!cache.load(key, format, binary)) return 0;
+
+	GLuint program = glCreateProgram();
+	glProgramBinary(program, format, &binary[0], (GLsizei)binary.size());
+
+	// The driver may still reject a binary, e.g., after an update that kept its version string.
+	GLint linked;
+	glGetProgramiv(program, GL_LINK_STATUS, &linked);
+	if (!linked)
+	{
+		glDeleteProgram(program);
+		cache.remove(key);
+		return 0;
+	}
+	return program;
+}
+
+GLuint ShaderManager::compile(const char* vShaderFile, const string& vSource, const char* fShaderFile, const string& fSource)
+{
+	struct Shader {
+		const char*  filename;
+		GLenum       type;
+		const string* source;
+	}  shaders[2] = {
+		{ vShaderFile, GL_VERTEX_SHADER, &vSource },
+		{ fShaderFile, GL_FRAGMENT_SHADER, &fSource }
+	};
+
+	GLuint program = glCreateProgram();
+
+	for (int i = 0; i < 2; ++i) {
+		Shader& s = shaders[i];
+		const GLchar* source = s.source->c_str();
+
+		GLuint shader = glCreateShader(s.type);
+		glShaderSource(shader, 1, &source, NULL);
+		glCompileShader(shader);
+
+		GLint  compiled;
+		glGetShaderiv(shader, GL_COMPILE_STATUS, &compiled);
+		if (!compiled) {
+			cerr << s.filename << " failed to compile:" << endl;
+			GLint  logSize;
+			glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &logSize);
+			char* logMsg = new char[logSize];
+			glGetShaderInfoLog(shader, logSize, NULL, logMsg);
+			cerr << logMsg << endl;
+			delete[] logMsg;
+
+			glDeleteShader(shader);
+			glDeleteProgram(program);
+			return 0;
+		}
+
+		glAttachShader(program, shader);
+		glDeleteShader(shader); // Freed along with the program.
+	}
+
+	if (isBinarySupported())
+		glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+
+	// The compatibility profile only draws when attribute 0 is an array, which the mesh always is.
+	glBindAttribLocation(program, 0, "vPosition");
+
+	/* link  and error check */
+	glLinkProgram(program);
+
+	GLint  linked;
+	glGetProgramiv(program, GL_LINK_STATUS, &linked);
+	if (!linked) {
+		cerr << "Shader program failed to link" << endl;
+		GLint  logSize;
+		glGetProgramiv(program, GL_INFO_LOG_LENGTH, &logSize);
+		char* logMsg = new char[logSize];
+		glGetProgramInfoLog(program, logSize, NULL, logMsg);
+		cerr << logMsg << endl;
+		delete[] logMsg;
+
+		glDeleteProgram(program);
+		return 0;
+	}
+
+	return program;
+}
+
+void ShaderManager::storeBinary(unsigned long long key, GLuint program)
+{
+	GLint length = 0;
+	glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+	if (length <= 0) return;
+
+	vector<char> binary(length);
+	GLenum format;
+	glGetProgramBinary(program, length, &length, &format, &binary[0]);
+	binary.resize(length);
+	cache.store(key, format, binary);
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <string>
+
+#include "ShaderCache.h"
+
+using namespace std;
+
+#define SHADER_CACHE_PREFIX "shadercache_" // Cache files are written to the working directory.
+
+// Loads shader programs. A linked program is saved as a binary when the driver supports
+// ARB_get_program_binary, and later launches with the same sources and driver load that
+// binary instead of compiling and linking again.
+class ShaderManager
+{
+public:
+	// Return a linked program made of the vertex and fragment shaders in the given files. Exits
+	// if a file cannot be read or the shaders fail to compile or link, as there is nothing to
+	// draw with.
+	GLuint load(const char* vShaderFile, const char* fShaderFile);
+
+	// As load, but print what went wrong and return 0 instead of exiting, e.g., when reloading
+	// shaders that are being edited. Does not make the program current, so it may be called on a
+	// context shared with the one that draws.
+	GLuint tryLoad(const char* vShaderFile, const char* fShaderFile);
+
+	// Whether the last program loaded came from the cache.
+	bool wasCached() { return cached; }
+
+	static ShaderManager& getInstance() {
+		static ShaderManager instance;
+		return instance;
+	}
+
+private:
+	ShaderCache cache;
+	bool cached = false;
+
+	bool isBinarySupported();
+	unsigned long long getKey(const string& vSource, const string& fSource);
+	GLuint loadBinary(unsigned long long key);
+	GLuint compile(const char* vShaderFile, const string& vSource, const char* fShaderFile, const string& fSource);
+	void storeBinary(unsigned long long key, GLuint program);
+
+	ShaderManager() : cache(SHADER_CACHE_PREFIX) {}
+	ShaderManager(ShaderManager const&);
+	void operator=(ShaderManager const&);
+};
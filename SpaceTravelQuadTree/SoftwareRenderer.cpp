@@ -0,0 +1,534 @@
+#include <algorithm>
+#include <cmath>
+#include <condition_variable>
+#include <fstream>
+#include <mutex>
+
+#include "SoftwareRenderer.h"
+
+// Holds the threads rendering a frame until all of them have reached it.
+class Barrier
+{
+public:
+	explicit Barrier(int count) : count(count) {}
+
+	void wait()
+	{
+		unique_lock<mutex> lock(barrierMutex);
+		int arrival = generation;
+		if (++waiting == count)
+		{
+			waiting = 0;
+			generation++;
+			released.notify_all();
+		}
+		else
+			released.wait(lock, [this, arrival]() { return generation != arrival; });
+	}
+
+private:
+	mutex barrierMutex;
+	condition_variable released;
+	int count;
+	int waiting = 0;
+	int generation = 0;
+};
+
+SoftwareRenderer::SoftwareRenderer(int width, int height, int threadCount)
+	: width(width), height(height), threadCount(threadCount < 1 ? 1 : threadCount)
+{
+	tilesX = (width + SOFTWARE_TILE_SIZE - 1) / SOFTWARE_TILE_SIZE;
+	tilesY = (height + SOFTWARE_TILE_SIZE - 1) / SOFTWARE_TILE_SIZE;
+	color.resize(3 * width * height);
+	depth.resize(width * height);
+
+	bins.resize(this->threadCount);
+	for (Bins& threadBins : bins)
+		threadBins.tiles.resize(tilesX * tilesY);
+}
+
+void SoftwareRenderer::uploadMesh(MeshId mesh, const glm::vec3* vertices, int count, MeshMode mode,
+	const unsigned short* edges, int edgeCount)
+{
+	meshes[mesh].assign(vertices, vertices + count);
+	this->edges[mesh].assign(edges, edges + 2 * edgeCount);
+	modes[mesh] = mode;
+}
+
+void SoftwareRenderer::beginFrame()
+{
+	fill(color.begin(), color.end(), (unsigned char)0);
+	fill(depth.begin(), depth.end(), 1.0f);
+	draws.clear();
+	primitiveCount = 0;
+}
+
+void SoftwareRenderer::setCamera(const Viewport& viewport, const glm::mat4& projection, const glm::mat4& view)
+{
+	this->viewport = viewport;
+	this->projection = projection;
+	viewProjection = projection * view;
+}
+
+void SoftwareRenderer::submit(const DrawBatch& batch)
+{
+	const vector<glm::vec3>& mesh = meshes[batch.mesh];
+	const vector<unsigned short>& meshEdges = edges[batch.mesh];
+	bool isEdgeList = batch.wireframe && !meshEdges.empty();
+
+	// The quad of an impostor reaches as far from its center in x as in y.
+	float impostorRadius = batch.isImpostor ? fabs(mesh[0].x) : 0.0f;
+	float impostorSize[2] = { impostorRadius * projection[0][0] * 0.5f * viewport.width,
+		impostorRadius * projection[1][1] * 0.5f * viewport.height };
+	for (const DrawItem& item : batch.items)
+	{
+		Draw draw = { &mesh[0], (int)mesh.size(), isEdgeList ? &meshEdges[0] : nullptr, (int)meshEdges.size() / 2,
+			modes[batch.mesh], batch.wireframe, batch.lineWidth,
+			viewProjection * item.model, viewport, { item.color[0], item.color[1], item.color[2] },
+			batch.isImpostor, { impostorSize[0], impostorSize[1] } };
+		draws.push_back(draw);
+	}
+}
+
+// The cache is drawn in place: the draws before it are rasterized, the viewport cleared for the
+// cached ones, and the result saved.
+void SoftwareRenderer::beginCache()
+{
+	flush();
+	for (int y = viewport.y; y < viewport.y + viewport.height; y++)
+	{
+		fill(color.begin() + 3 * (y * width + viewport.x), color.begin() + 3 * (y * width + viewport.x + viewport.width),
+			(unsigned char)0);
+		fill(depth.begin() + y * width + viewport.x, depth.begin() + y * width + viewport.x + viewport.width, 1.0f);
+	}
+	isCacheValid = false;
+}
+
+void SoftwareRenderer::endCache(unsigned int key)
+{
+	flush();
+	cacheViewport = viewport;
+	cacheColor.resize(3 * viewport.width * viewport.height);
+	cacheDepth.resize(viewport.width * viewport.height);
+	copyCache(true);
+	cacheKey = key;
+	isCacheValid = true;
+}
+
+bool SoftwareRenderer::drawCache(unsigned int key)
+{
+	if (!isCacheValid || key != cacheKey || cacheViewport.width != viewport.width ||
+		cacheViewport.height != viewport.height)
+		return false;
+	flush();
+	copyCache(false);
+	return true;
+}
+
+// Copy the current viewport into the cache if isSaved, else the cache into the viewport.
+void SoftwareRenderer::copyCache(bool isSaved)
+{
+	for (int row = 0; row < viewport.height; row++)
+	{
+		unsigned char* image = &color[3 * ((viewport.y + row) * width + viewport.x)];
+		float* depths = &depth[(viewport.y + row) * width + viewport.x];
+		unsigned char* cachedImage = &cacheColor[3 * row * viewport.width];
+		float* cachedDepths = &cacheDepth[row * viewport.width];
+		if (isSaved)
+		{
+			copy(image, image + 3 * viewport.width, cachedImage);
+			copy(depths, depths + viewport.width, cachedDepths);
+		}
+		else
+		{
+			copy(cachedImage, cachedImage + 3 * viewport.width, image);
+			copy(cachedDepths, cachedDepths + viewport.width, depths);
+		}
+	}
+}
+
+void SoftwareRenderer::present()
+{
+	flush();
+}
+
+bool SoftwareRenderer::save(const char* path)
+{
+	ofstream file(path, ios::binary | ios::trunc);
+	if (!file) return false;
+
+	// PPM rows go from the top down.
+	file << "P6\n" << width << " " << height << "\n255\n";
+	for (int y = height - 1; y >= 0; y--)
+		file.write((const char*)&color[3 * y * width], 3 * width);
+	return (bool)file;
+}
+
+void SoftwareRenderer::flush()
+{
+	if (draws.empty()) return;
+
+	Barrier barrier(threadCount);
+	atomic<int> nextTile(0);
+
+	vector<thread> workers;
+	for (int t = 1; t < threadCount; t++)
+		workers.push_back(thread(&SoftwareRenderer::runBatches, this, t, ref(barrier), ref(nextTile)));
+	runBatches(0, barrier, nextTile);
+	for (thread& worker : workers)
+		worker.join();
+
+	for (Bins& threadBins : bins)
+		primitiveCount += threadBins.count;
+	draws.clear();
+}
+
+void SoftwareRenderer::runBatches(int threadIndex, Barrier& barrier, atomic<int>& nextTile)
+{
+	Bins& own = bins[threadIndex];
+	own.count = 0;
+
+	for (int first = 0; first < (int)draws.size(); first += SOFTWARE_BATCH_DRAWS)
+	{
+		// Every thread has finished rasterizing the previous batch, so the counter is free.
+		if (threadIndex == 0) nextTile = 0;
+
+		// Each thread sets up a contiguous share of the batch, so that taking the threads' bins in
+		// turn keeps the draw order.
+		int count = min(SOFTWARE_BATCH_DRAWS, (int)draws.size() - first);
+		int begin = first + count * threadIndex / threadCount, end = first + count * (threadIndex + 1) / threadCount;
+		own.primitives.clear();
+		for (vector<int>& tile : own.tiles)
+			tile.clear();
+		for (int i = begin; i < end; i++)
+			setUp(draws[i], own);
+		own.count += own.primitives.size();
+		barrier.wait();
+
+		int tile;
+		while ((tile = nextTile++) < tilesX * tilesY)
+			rasterizeTile(tile);
+		barrier.wait();
+	}
+}
+
+void SoftwareRenderer::setUp(const Draw& draw, Bins& bins)
+{
+	if (draw.isImpostor)
+	{
+		setUpDisc(draw, bins);
+		return;
+	}
+
+	bins.clip.resize(draw.count);
+	for (int i = 0; i < draw.count; i++)
+		bins.clip[i] = draw.transform * glm::vec4(draw.vertices[i], 1.0f);
+	const vector<glm::vec4>& v = bins.clip;
+
+	if (draw.edges)
+	{
+		for (int i = 0; i < draw.edgeCount; i++)
+			setUpLine(v[draw.edges[2 * i]], v[draw.edges[2 * i + 1]], draw, bins);
+		return;
+	}
+
+	if (draw.mode == MESH_LINE_STRIP)
+	{
+		for (int i = 0; i + 1 < draw.count; i++)
+			setUpLine(v[i], v[i + 1], draw, bins);
+		return;
+	}
+
+	for (int i = 1; i + 1 < draw.count; i++)
+	{
+		if (draw.wireframe)
+		{
+			setUpLine(v[0], v[i], draw, bins);
+			setUpLine(v[i], v[i + 1], draw, bins);
+			setUpLine(v[i + 1], v[0], draw, bins);
+		}
+		else
+			setUpTriangle(v[0], v[i], v[i + 1], draw, bins);
+	}
+}
+
+// Signed distances of a point in clip coordinates to the six planes of the view volume, positive
+// inside: left, right, bottom, top, near, far.
+static void getClipDistances(const glm::vec4& p, float* d)
+{
+	d[0] = p.w + p.x; d[1] = p.w - p.x;
+	d[2] = p.w + p.y; d[3] = p.w - p.y;
+	d[4] = p.w + p.z; d[5] = p.w - p.z;
+}
+
+// Window coordinates of a point in clip coordinates inside the view volume.
+static void toWindow(const glm::vec4& p, const Viewport& viewport, float& x, float& y, float& z)
+{
+	x = viewport.x + (p.x / p.w + 1) * 0.5f * viewport.width;
+	y = viewport.y + (p.y / p.w + 1) * 0.5f * viewport.height;
+	z = (p.z / p.w + 1) * 0.5f;
+}
+
+void SoftwareRenderer::setUpLine(const glm::vec4& a, const glm::vec4& b, const Draw& draw, Bins& bins)
+{
+	// Clip to the view volume (Liang-Barsky).
+	float da[6], db[6];
+	getClipDistances(a, da);
+	getClipDistances(b, db);
+	float t0 = 0, t1 = 1;
+	for (int i = 0; i < 6; i++)
+	{
+		if (da[i] < 0 && db[i] < 0) return;
+		if (da[i] < 0) t0 = max(t0, da[i] / (da[i] - db[i]));
+		else if (db[i] < 0) t1 = min(t1, da[i] / (da[i] - db[i]));
+	}
+	if (t0 > t1) return;
+
+	Primitive line;
+	toWindow(a + (b - a) * t0, draw.viewport, line.x[0], line.y[0], line.z[0]);
+	toWindow(a + (b - a) * t1, draw.viewport, line.x[1], line.y[1], line.z[1]);
+	copy(draw.color, draw.color + 3, line.color);
+	line.lineWidth = (unsigned char)draw.lineWidth;
+	line.isDisc = false;
+	line.viewport = draw.viewport;
+	bin(line, 2, bins);
+}
+
+void SoftwareRenderer::setUpTriangle(const glm::vec4& a, const glm::vec4& b, const glm::vec4& c, const Draw& draw, Bins& bins)
+{
+	// Triangles entirely outside one plane are dropped.
+	float d[3][6];
+	getClipDistances(a, d[0]);
+	getClipDistances(b, d[1]);
+	getClipDistances(c, d[2]);
+	for (int i = 0; i < 6; i++)
+		if (d[0][i] < 0 && d[1][i] < 0 && d[2][i] < 0) return;
+
+	// Only the near plane is clipped against, as points behind the eye have no window
+	// coordinates. Pixels beyond the side planes are outside the viewport, which the rasterizer
+	// keeps to, and those beyond the far plane outside the depth range.
+	const glm::vec4* in[3] = { &a, &b, &c };
+	glm::vec4 polygon[4];
+	int n = 0;
+	for (int i = 0; i < 3; i++)
+	{
+		int j = (i + 1) % 3;
+		if (d[i][4] >= 0) polygon[n++] = *in[i];
+		if ((d[i][4] >= 0) != (d[j][4] >= 0))
+			polygon[n++] = *in[i] + (*in[j] - *in[i]) * (d[i][4] / (d[i][4] - d[j][4]));
+	}
+
+	for (int i = 1; i + 1 < n; i++)
+	{
+		Primitive triangle;
+		toWindow(polygon[0], draw.viewport, triangle.x[0], triangle.y[0], triangle.z[0]);
+		toWindow(polygon[i], draw.viewport, triangle.x[1], triangle.y[1], triangle.z[1]);
+		toWindow(polygon[i + 1], draw.viewport, triangle.x[2], triangle.y[2], triangle.z[2]);
+		copy(draw.color, draw.color + 3, triangle.color);
+		triangle.lineWidth = 0;
+		triangle.isDisc = false;
+		triangle.viewport = draw.viewport;
+		bin(triangle, 3, bins);
+	}
+}
+
+// An impostor's quad keeps the depth of its center, so it is drawn whole or, when the center is
+// beyond the near or far plane, not at all. Like other primitives it is cut at its viewport.
+void SoftwareRenderer::setUpDisc(const Draw& draw, Bins& bins)
+{
+	glm::vec4 center = draw.transform * glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+	float d[6];
+	getClipDistances(center, d);
+	if (d[4] < 0 || d[5] < 0) return;
+
+	Primitive disc;
+	toWindow(center, draw.viewport, disc.x[0], disc.y[0], disc.z[0]);
+	disc.x[1] = draw.impostorSize[0] / center.w;
+	disc.y[1] = draw.impostorSize[1] / center.w;
+	copy(draw.color, draw.color + 3, disc.color);
+	disc.lineWidth = 0;
+	disc.isDisc = true;
+	disc.viewport = draw.viewport;
+	bin(disc, 1, bins);
+}
+
+void SoftwareRenderer::bin(const Primitive& primitive, int vertexCount, Bins& bins)
+{
+	float minX = primitive.x[0], maxX = primitive.x[0], minY = primitive.y[0], maxY = primitive.y[0];
+	for (int i = 1; i < vertexCount; i++)
+	{
+		minX = min(minX, primitive.x[i]); maxX = max(maxX, primitive.x[i]);
+		minY = min(minY, primitive.y[i]); maxY = max(maxY, primitive.y[i]);
+	}
+	if (primitive.isDisc)
+	{
+		minX -= primitive.x[1]; maxX += primitive.x[1];
+		minY -= primitive.y[1]; maxY += primitive.y[1];
+	}
+
+	// Wide lines reach past their ends by up to half their width. Only the tiles of the viewport
+	// are drawn into.
+	float margin = (float)primitive.lineWidth;
+	int x0 = max(0, primitive.viewport.x), x1 = min(width, primitive.viewport.x + primitive.viewport.width);
+	int y0 = max(0, primitive.viewport.y), y1 = min(height, primitive.viewport.y + primitive.viewport.height);
+	if (maxX + margin < x0 || maxY + margin < y0 || minX - margin >= x1 || minY - margin >= y1) return;
+	int tx0 = max(x0 / SOFTWARE_TILE_SIZE, (int)floor((minX - margin) / SOFTWARE_TILE_SIZE));
+	int ty0 = max(y0 / SOFTWARE_TILE_SIZE, (int)floor((minY - margin) / SOFTWARE_TILE_SIZE));
+	int tx1 = min((x1 - 1) / SOFTWARE_TILE_SIZE, (int)floor((maxX + margin) / SOFTWARE_TILE_SIZE));
+	int ty1 = min((y1 - 1) / SOFTWARE_TILE_SIZE, (int)floor((maxY + margin) / SOFTWARE_TILE_SIZE));
+
+	int index = (int)bins.primitives.size();
+	bins.primitives.push_back(primitive);
+	for (int ty = ty0; ty <= ty1; ty++)
+		for (int tx = tx0; tx <= tx1; tx++)
+			bins.tiles[ty * tilesX + tx].push_back(index);
+}
+
+void SoftwareRenderer::rasterizeTile(int tile)
+{
+	int x0 = tile % tilesX * SOFTWARE_TILE_SIZE, y0 = tile / tilesX * SOFTWARE_TILE_SIZE;
+	int x1 = min(x0 + SOFTWARE_TILE_SIZE, width), y1 = min(y0 + SOFTWARE_TILE_SIZE, height);
+
+	for (Bins& threadBins : bins)
+		for (int index : threadBins.tiles[tile])
+		{
+			const Primitive& primitive = threadBins.primitives[index];
+			if (primitive.isDisc)
+				rasterizeDisc(primitive, x0, y0, x1, y1);
+			else if (primitive.lineWidth > 0)
+				rasterizeLine(primitive, x0, y0, x1, y1);
+			else
+				rasterizeTriangle(primitive, x0, y0, x1, y1);
+		}
+}
+
+// Narrow the rectangle [x0, x1) x [y0, y1) to the pixels inside the viewport.
+static void scissor(const Viewport& viewport, int& x0, int& y0, int& x1, int& y1)
+{
+	x0 = max(x0, viewport.x); x1 = min(x1, viewport.x + viewport.width);
+	y0 = max(y0, viewport.y); y1 = min(y1, viewport.y + viewport.height);
+}
+
+// Draw the pixels of the line inside the rectangle [x0, x1) x [y0, y1) and its viewport. Along
+// its major axis the line covers the pixels whose centers lie between its ends, leaving out the
+// last one as OpenGL's diamond exit rule does, and it is lineWidth pixels wide across it.
+void SoftwareRenderer::rasterizeLine(const Primitive& line, int x0, int y0, int x1, int y1)
+{
+	scissor(line.viewport, x0, y0, x1, y1);
+	float dx = line.x[1] - line.x[0], dy = line.y[1] - line.y[0], dz = line.z[1] - line.z[0];
+	bool xMajor = fabs(dx) >= fabs(dy);
+	float start = xMajor ? line.x[0] : line.y[0], length = xMajor ? dx : dy;
+	if (length == 0) return;
+
+	// Pixel centers in [start, end) going forwards, in (end, start] going backwards.
+	int first, last;
+	if (length > 0)
+	{
+		first = (int)ceil(start - 0.5f);
+		last = (int)ceil(start + length - 0.5f);
+	}
+	else
+	{
+		first = (int)floor(start + length - 0.5f) + 1;
+		last = (int)floor(start - 0.5f) + 1;
+	}
+	first = max(first, xMajor ? x0 : y0);
+	last = min(last, xMajor ? x1 : y1);
+
+	float spread = (line.lineWidth - 1) * 0.5f;
+	for (int i = first; i < last; i++)
+	{
+		float t = (i + 0.5f - start) / length;
+		float minor = xMajor ? line.y[0] + t * dy : line.x[0] + t * dx;
+		float z = line.z[0] + t * dz;
+		int m = (int)floor(minor - spread);
+		for (int k = 0; k < line.lineWidth; k++, m++)
+		{
+			if (xMajor && m >= y0 && m < y1) plot(i, m, z, line.color);
+			else if (!xMajor && m >= x0 && m < x1) plot(m, i, z, line.color);
+		}
+	}
+}
+
+// Whether the edge from (ax, ay) to (bx, by) of a counterclockwise triangle is a top or a left
+// edge, whose pixel centers belong to the triangle.
+static bool isTopLeft(float ax, float ay, float bx, float by)
+{
+	return (ay == by && bx < ax) || by < ay;
+}
+
+// Draw the pixels of the triangle inside the rectangle [x0, x1) x [y0, y1) and its viewport:
+// those whose centers are inside it or on its top or left edges.
+void SoftwareRenderer::rasterizeTriangle(const Primitive& triangle, int x0, int y0, int x1, int y1)
+{
+	scissor(triangle.viewport, x0, y0, x1, y1);
+	float x[3] = { triangle.x[0], triangle.x[1], triangle.x[2] };
+	float y[3] = { triangle.y[0], triangle.y[1], triangle.y[2] };
+	float z[3] = { triangle.z[0], triangle.z[1], triangle.z[2] };
+	float area = (x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]);
+	if (area == 0) return;
+	if (area < 0)
+	{
+		swap(x[1], x[2]); swap(y[1], y[2]); swap(z[1], z[2]);
+		area = -area;
+	}
+
+	x0 = max(x0, (int)floor(min(x[0], min(x[1], x[2])))); x1 = min(x1, (int)ceil(max(x[0], max(x[1], x[2]))));
+	y0 = max(y0, (int)floor(min(y[0], min(y[1], y[2])))); y1 = min(y1, (int)ceil(max(y[0], max(y[1], y[2]))));
+
+	bool topLeft[3];
+	for (int i = 0; i < 3; i++)
+		topLeft[i] = isTopLeft(x[(i + 1) % 3], y[(i + 1) % 3], x[(i + 2) % 3], y[(i + 2) % 3]);
+
+	for (int py = y0; py < y1; py++)
+		for (int px = x0; px < x1; px++)
+		{
+			float cx = px + 0.5f, cy = py + 0.5f, w[3];
+			bool inside = true;
+			for (int i = 0; i < 3 && inside; i++)
+			{
+				// Twice the area of the part of the triangle facing vertex i.
+				float ax = x[(i + 1) % 3], ay = y[(i + 1) % 3], bx = x[(i + 2) % 3], by = y[(i + 2) % 3];
+				w[i] = (bx - ax) * (cy - ay) - (cx - ax) * (by - ay);
+				inside = w[i] > 0 || (w[i] == 0 && topLeft[i]);
+			}
+			if (!inside) continue;
+
+			float depthValue = (w[0] * z[0] + w[1] * z[1] + w[2] * z[2]) / area;
+			if (depthValue >= 0 && depthValue <= 1) plot(px, py, depthValue, triangle.color);
+		}
+}
+
+// Draw the pixels of the disc inside the rectangle [x0, x1) x [y0, y1) and its viewport: those
+// whose centers are inside the ellipse, shaded as the fragment shader shades impostors.
+void SoftwareRenderer::rasterizeDisc(const Primitive& disc, int x0, int y0, int x1, int y1)
+{
+	scissor(disc.viewport, x0, y0, x1, y1);
+	float cx = disc.x[0], cy = disc.y[0], rx = disc.x[1], ry = disc.y[1];
+	x0 = max(x0, (int)floor(cx - rx)); x1 = min(x1, (int)ceil(cx + rx));
+	y0 = max(y0, (int)floor(cy - ry)); y1 = min(y1, (int)ceil(cy + ry));
+
+	for (int py = y0; py < y1; py++)
+		for (int px = x0; px < x1; px++)
+		{
+			float u = (px + 0.5f - cx) / rx, v = (py + 0.5f - cy) / ry;
+			float r2 = u * u + v * v;
+			if (r2 >= 1.0f) continue;
+			float shade = 0.3f + 0.7f * sqrt(1.0f - r2);
+			unsigned char rgb[3];
+			for (int k = 0; k < 3; k++)
+				rgb[k] = (unsigned char)(disc.color[k] * shade + 0.5f);
+			plot(px, py, disc.z[0], rgb);
+		}
+}
+
+// Write the pixel if it passes the GL_LESS depth test.
+void SoftwareRenderer::plot(int x, int y, float z, const unsigned char* rgb)
+{
+	int pixel = y * width + x;
+	if (z >= depth[pixel]) return;
+	depth[pixel] = z;
+	color[3 * pixel] = rgb[0];
+	color[3 * pixel + 1] = rgb[1];
+	color[3 * pixel + 2] = rgb[2];
+}
@@ -0,0 +1,129 @@
+#pragma once
+
+#include <atomic>
+#include <glm/glm.hpp>
+#include <thread>
+#include <vector>
+
+#include "RenderBackend.h"
+
+using namespace std;
+
+class Barrier;
+
+#define SOFTWARE_TILE_SIZE 64 // Pixels on a side of the tiles that are rasterized in parallel.
+#define SOFTWARE_BATCH_DRAWS 256 // Draws set up and binned at a time, which bounds the memory a
+                                 // frame needs for its primitives.
+
+// Backend that renders on the CPU, so that frames can be timed and inspected on machines
+// without a GPU. Submitted items are kept as draws until present(), which processes them in
+// batches: the threads split the draws of a batch to transform, clip and bin their primitives
+// into screen tiles, then split the tiles to rasterize them against a depth buffer. A tile takes
+// its primitives in draw order, so the image does not depend on the number of threads.
+// Triangles are filled or, as with the GL_LINE polygon mode the game uses, drawn as wireframes.
+// Impostors are drawn as shaded discs, as the game's shaders draw them.
+class SoftwareRenderer : public RenderBackend
+{
+public:
+	SoftwareRenderer(int width, int height, int threadCount = (int)thread::hardware_concurrency());
+
+	void uploadMesh(MeshId mesh, const glm::vec3* vertices, int count, MeshMode mode, const unsigned short* edges,
+		int edgeCount) override;
+	void beginFrame() override;
+	void setCamera(const Viewport& viewport, const glm::mat4& projection, const glm::mat4& view) override;
+	void submit(const DrawBatch& batch) override;
+	void beginCache() override;
+	void endCache(unsigned int key) override;
+	bool drawCache(unsigned int key) override;
+	void present() override;
+
+	// Write the color buffer as a binary PPM image. Returns false if the file cannot be written.
+	bool save(const char* path);
+
+	int getWidth() { return width; }
+	int getHeight() { return height; }
+
+	// RGB color of pixel (x, y), counted from the bottom left corner as in OpenGL.
+	const unsigned char* getPixel(int x, int y) { return &color[3 * (y * width + x)]; }
+
+	// Lines and triangles rasterized in the last frame, after clipping. Those drawn into a cache
+	// are counted in the frame that drew them only.
+	long long getPrimitiveCount() { return primitiveCount; }
+
+private:
+	// One item of a batch, with the projection, view and model matrices multiplied into transform.
+	struct Draw
+	{
+		const glm::vec3* vertices;
+		int count;
+		const unsigned short* edges; // Drawn as lines instead of the primitives if not null.
+		int edgeCount;
+		MeshMode mode;
+		bool wireframe;
+		int lineWidth;
+		glm::mat4 transform;
+		Viewport viewport;
+		unsigned char color[3];
+		bool isImpostor;
+		float impostorSize[2]; // Half the width and height of an impostor in pixels, times its w.
+	};
+
+	// Clipped line or triangle in window coordinates, with depths in [0, 1]. Lines use the first
+	// two vertices. A disc is centered on the first vertex, with half its width and height as the
+	// coordinates of the second.
+	struct Primitive
+	{
+		float x[3], y[3], z[3];
+		unsigned char color[3];
+		unsigned char lineWidth; // 0 for a triangle or a disc.
+		bool isDisc;
+		Viewport viewport; // No pixel outside it is drawn.
+	};
+
+	// What one thread sets up from its share of a batch: the primitives, and for each tile the
+	// indices of those that overlap it.
+	struct Bins
+	{
+		vector<glm::vec4> clip; // Clip coordinates of the vertices of the draw being set up.
+		vector<Primitive> primitives;
+		vector<vector<int> > tiles;
+		long long count; // Primitives set up in the current frame.
+	};
+
+	int width, height, threadCount;
+	int tilesX, tilesY;
+	vector<unsigned char> color;
+	vector<float> depth;
+
+	vector<glm::vec3> meshes[MESH_COUNT];
+	vector<unsigned short> edges[MESH_COUNT];
+	MeshMode modes[MESH_COUNT];
+	Viewport viewport;
+	glm::mat4 projection, viewProjection;
+
+	vector<Draw> draws;
+
+	// Colors and depths of the cached viewport, rows from the bottom up.
+	Viewport cacheViewport;
+	vector<unsigned char> cacheColor;
+	vector<float> cacheDepth;
+	unsigned int cacheKey = 0;
+	bool isCacheValid = false;
+	vector<Bins> bins;
+	long long primitiveCount = 0;
+
+	void flush();
+	void copyCache(bool isSaved);
+	void runBatches(int threadIndex, Barrier& barrier, atomic<int>& nextTile);
+	void setUp(const Draw& draw, Bins& bins);
+	void setUpLine(const glm::vec4& a, const glm::vec4& b, const Draw& draw, Bins& bins);
+	void setUpTriangle(const glm::vec4& a, const glm::vec4& b, const glm::vec4& c, const Draw& draw, Bins& bins);
+	void setUpDisc(const Draw& draw, Bins& bins);
+	void bin(const Primitive& primitive, int vertexCount, Bins& bins);
+
+	void rasterizeTile(int tile);
+	void rasterizeLine(const Primitive& line, int x0, int y0, int x1, int y1);
+	void rasterizeTriangle(const Primitive& triangle, int x0, int y0, int x1, int y1);
+	void rasterizeDisc(const Primitive& disc, int x0, int y0, int x1, int y1);
+	void plot(int x, int y, float z, const unsigned char* rgb);
+};
@@ -0,0 +1,92 @@
+#include <algorithm>
+
+#include "SweepAndPrune.h"
+
+int SweepAndPrune::findDominantAxis(const float* x, const float* y, const float* z, int n)
+{
+	const float* centers[3] = { x, y, z };
+	int dominant = 0;
+	double largest = -1;
+
+	for (int a = 0; a < 3; a++)
+	{
+		double sum = 0, sumSquares = 0;
+		for (int i = 0; i < n; i++)
+		{
+			sum += centers[a][i];
+			sumSquares += (double)centers[a][i] * centers[a][i];
+		}
+		double variance = sumSquares / n - (sum / n) * (sum / n);
+		if (variance > largest)
+		{
+			largest = variance;
+			dominant = a;
+		}
+	}
+	return dominant;
+}
+
+void SweepAndPrune::findPairs(const float* x, const float* y, const float* z, const float* r, int n,
+	vector<pair<int, int> >& pairs)
+{
+	if (n == 0) return;
+
+	const float* centers[3] = { x, y, z };
+	int dominant = findDominantAxis(x, y, z, n);
+	const float* c = centers[dominant];
+
+	lower.resize(n);
+	for (int i = 0; i < n; i++)
+		lower[i] = c[i] - r[i];
+
+	if (dominant != axis || (int)order.size() != n)
+	{
+		// Nothing to be coherent with: sort from scratch.
+		axis = dominant;
+		order.resize(n);
+		for (int i = 0; i < n; i++)
+			order[i] = i;
+		sort(order.begin(), order.end(), [this](int a, int b) { return lower[a] < lower[b]; });
+	}
+	else
+	{
+		for (int i = 1; i < n; i++)
+		{
+			int sphere = order[i];
+			float key = lower[sphere];
+			int k = i - 1;
+			while (k >= 0 && lower[order[k]] > key)
+			{
+				order[k + 1] = order[k];
+				k--;
+				swaps++;
+			}
+			order[k + 1] = sphere;
+		}
+	}
+
+	// Sweep: a sphere can only overlap the ones after it in the order that start before it ends.
+	int axis1 = (axis + 1) % 3, axis2 = (axis + 2) % 3;
+	const float* c1 = centers[axis1];
+	const float* c2 = centers[axis2];
+	for (int i = 0; i < n; i++)
+	{
+		int a = order[i];
+		float upper = c[a] + r[a];
+		for (int k = i + 1; k < n && lower[order[k]] <= upper; k++)
+		{
+			int b = order[k];
+			float reach = r[a] + r[b];
+			if (c1[a] - c1[b] <= reach && c1[b] - c1[a] <= reach &&
+				c2[a] - c2[b] <= reach && c2[b] - c2[a] <= reach)
+				pairs.push_back(a < b ? make_pair(a, b) : make_pair(b, a));
+		}
+	}
+}
+
+int SweepAndPrune::takeSwaps()
+{
+	int count = swaps;
+	swaps = 0;
+	return count;
+}
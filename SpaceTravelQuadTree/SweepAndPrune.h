@@ -0,0 +1,31 @@
+#pragma once
+
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+// Sweep-and-prune broadphase over spheres. The spheres are kept sorted by the lower end of
+// their extent along the axis on which their centers are most spread out. As they move little
+// between two calls the order is repaired with an insertion sort, which is close to linear on
+// a nearly sorted array, and then swept to find the pairs whose bounding boxes overlap.
+class SweepAndPrune
+{
+public:
+	// Append to pairs every pair (i, j), i < j, of the n spheres centered at (x[i],y[i],z[i]) of
+	// radius r[i] whose bounding boxes overlap. Spheres must keep the same index from one call
+	// to the next for the previous order to be reused.
+	void findPairs(const float* x, const float* y, const float* z, const float* r, int n,
+		vector<pair<int, int> >& pairs);
+
+	// Number of swaps done by the insertion sort since the last call.
+	int takeSwaps();
+
+private:
+	int axis = -1; // 0, 1 or 2 for x, y or z.
+	vector<int> order; // Sphere indices sorted by the lower end of their extent on the axis.
+	vector<float> lower;
+	int swaps = 0;
+
+	int findDominantAxis(const float* x, const float* y, const float* z, int n);
+};
@@ -0,0 +1,101 @@
+#include <iomanip>
+
+#include "TaskGraph.h"
+
+int TaskGraph::add(const string& name, function<void()> work, const vector<int>& dependencies, bool onMainThread)
+{
+	int id = (int)tasks.size();
+	Task task = { name, work, onMainThread, vector<int>(), (int)dependencies.size(), 0, 0 };
+	tasks.push_back(task);
+	for (int dependency : dependencies)
+		tasks[dependency].dependents.push_back(id);
+	return id;
+}
+
+void TaskGraph::run()
+{
+	runStart = chrono::steady_clock::now();
+	finished = 0;
+
+	unique_lock<mutex> lock(stateMutex);
+	for (int id = 0; id < (int)tasks.size(); id++)
+		if (tasks[id].waitingFor == 0) launch(id);
+
+	while (finished < (int)tasks.size())
+	{
+		if (mainReady.empty())
+		{
+			changed.wait(lock);
+			continue;
+		}
+
+		int id = mainReady.back();
+		mainReady.pop_back();
+		lock.unlock();
+		execute(id);
+		lock.lock();
+		finish(id);
+	}
+	lock.unlock();
+
+	// Every worker has finished its task, this only lets the threads go.
+	for (thread& worker : workers)
+		worker.join();
+	workers.clear();
+	totalTime = getTime();
+}
+
+void TaskGraph::report(ostream& out)
+{
+	double sum = 0;
+	out << "Startup:" << endl;
+	for (const Task& task : tasks)
+	{
+		out << "  " << left << setw(24) << task.name << right << fixed << setprecision(1)
+			<< setw(8) << task.start << " to " << setw(8) << task.end << " ms"
+			<< (task.onMainThread ? "  (main thread)" : "") << endl;
+		sum += task.end - task.start;
+	}
+	out << "  done after " << totalTime << " ms, " << sum << " ms one after another" << endl;
+	out.unsetf(ios::floatfield);
+}
+
+double TaskGraph::getTime()
+{
+	return chrono::duration<double, milli>(chrono::steady_clock::now() - runStart).count();
+}
+
+void TaskGraph::execute(int id)
+{
+	tasks[id].start = getTime();
+	tasks[id].work();
+	tasks[id].end = getTime();
+}
+
+// Called with stateMutex held.
+void TaskGraph::launch(int id)
+{
+	if (tasks[id].onMainThread)
+	{
+		mainReady.push_back(id);
+		changed.notify_all();
+	}
+	else
+		workers.push_back(thread(&TaskGraph::runWorker, this, id));
+}
+
+// Called with stateMutex held.
+void TaskGraph::finish(int id)
+{
+	finished++;
+	for (int dependent : tasks[id].dependents)
+		if (--tasks[dependent].waitingFor == 0) launch(dependent);
+	changed.notify_all();
+}
+
+void TaskGraph::runWorker(int id)
+{
+	execute(id);
+	lock_guard<mutex> lock(stateMutex);
+	finish(id);
+}
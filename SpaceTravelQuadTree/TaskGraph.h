@@ -0,0 +1,59 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+// Runs a set of tasks, each once all the tasks it depends on have finished, so that independent
+// work overlaps. Tasks that need the main thread, e.g., because they use the OpenGL context, run
+// on the thread that calls run(); the others each get a thread of their own. The time every task
+// started and finished is kept for report().
+class TaskGraph
+{
+public:
+	// Add a task and return its id. Its dependencies are ids of tasks already added, so the graph
+	// has no cycles.
+	int add(const string& name, function<void()> work, const vector<int>& dependencies = vector<int>(),
+		bool onMainThread = false);
+
+	// Run all the tasks and return when they have finished.
+	void run();
+
+	// Print when each task ran, in milliseconds from the start of run(), and how long run() took
+	// compared with running the tasks one after another.
+	void report(ostream& out);
+
+private:
+	struct Task
+	{
+		string name;
+		function<void()> work;
+		bool onMainThread;
+		vector<int> dependents;
+		int waitingFor; // Number of dependencies not finished yet.
+		double start, end; // Milliseconds from the start of run().
+	};
+	vector<Task> tasks;
+
+	mutex stateMutex; // Guards the members below while run() is going.
+	condition_variable changed;
+	vector<int> mainReady; // Tasks ready to run on the main thread.
+	vector<thread> workers;
+	int finished = 0;
+
+	chrono::steady_clock::time_point runStart;
+	double totalTime = 0;
+
+	double getTime();
+	void execute(int id);
+	void launch(int id);
+	void finish(int id);
+	void runWorker(int id);
+};
@@ -0,0 +1,214 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <emmintrin.h>
+#include <glm/gtc/packing.hpp>
+
+#include "VertexFormats.h"
+
+int getInstanceSize(InstanceFormat format)
+{
+	return format == INSTANCE_FORMAT_FLOAT ? 8 * sizeof(float) : 4 * sizeof(unsigned short) + 4;
+}
+
+int getInstanceColorOffset(InstanceFormat format, int count)
+{
+	return count * (format == INSTANCE_FORMAT_FLOAT ? 4 * sizeof(float) : 4 * sizeof(unsigned short));
+}
+
+void encodeMesh(const glm::vec3* vertices, int count, MeshFormat format, vector<unsigned char>& data, float& scale)
+{
+	if (format == MESH_FORMAT_FLOAT)
+	{
+		scale = 1.0f;
+		data.resize(count * sizeof(glm::vec3));
+		memcpy(&data[0], vertices, data.size());
+		return;
+	}
+
+	scale = 0.0f;
+	for (int i = 0; i < count; i++)
+		for (int k = 0; k < 3; k++)
+			scale = max(scale, fabs(vertices[i][k]));
+	if (scale == 0.0f) scale = 1.0f;
+
+	vector<float> normalized(4 * count, 0.0f);
+	for (int i = 0; i < count; i++)
+		for (int k = 0; k < 3; k++)
+			normalized[4 * i + k] = vertices[i][k] / scale;
+	data.resize(4 * count * sizeof(short));
+	packSnorm16(&normalized[0], (short*)&data[0], 4 * count);
+}
+
+void encodeInstances(const float* transforms, const unsigned char* colors, int count, InstanceFormat format,
+	vector<unsigned char>& data)
+{
+	data.resize(count * getInstanceSize(format));
+	if (count == 0) return;
+
+	unsigned char* colorData = &data[getInstanceColorOffset(format, count)];
+	if (format == INSTANCE_FORMAT_FLOAT)
+	{
+		memcpy(&data[0], transforms, 4 * count * sizeof(float));
+		unpackUnorm8(colors, (float*)colorData, 4 * count);
+	}
+	else
+	{
+		packHalf(transforms, (unsigned short*)&data[0], 4 * count);
+		memcpy(colorData, colors, 4 * count);
+	}
+}
+
+// Halves of four floats in the low 16 bits of each lane, rounding half away from zero as glm does.
+static __m128i floatToHalf(__m128 f)
+{
+	__m128i bits = _mm_castps_si128(f);
+	__m128i absolute = _mm_and_si128(bits, _mm_set1_epi32(0x7fffffff));
+	__m128i sign = _mm_srli_epi32(_mm_andnot_si128(absolute, bits), 16);
+
+	// Normal halves: round the mantissa at its 13th bit, letting a carry bump the exponent, then
+	// rebias the exponent. Too large a result is infinity.
+	__m128i normal = _mm_sub_epi32(_mm_srli_epi32(_mm_add_epi32(absolute, _mm_set1_epi32(0x1000)), 13),
+		_mm_set1_epi32((127 - 15) << 10));
+	__m128i isOverflow = _mm_cmpgt_epi32(normal, _mm_set1_epi32(0x7c00));
+	normal = _mm_or_si128(_mm_andnot_si128(isOverflow, normal), _mm_and_si128(isOverflow, _mm_set1_epi32(0x7c00)));
+
+	// Subnormal halves count units of 2^-24, which scaling by 2^24 makes whole. Below 2^-25 the
+	// half is zero, where adding 0.5 could round up.
+	__m128 scaled = _mm_mul_ps(_mm_castsi128_ps(absolute), _mm_set1_ps(16777216.0f));
+	__m128i subnormal = _mm_cvttps_epi32(_mm_add_ps(scaled, _mm_set1_ps(0.5f)));
+	subnormal = _mm_andnot_si128(_mm_cmplt_epi32(absolute, _mm_set1_epi32((127 - 25) << 23)), subnormal);
+
+	// NaNs keep the top of their payload, and at least one bit of it.
+	__m128i payload = _mm_srli_epi32(_mm_and_si128(absolute, _mm_set1_epi32(0x007fffff)), 13);
+	__m128i nan = _mm_or_si128(_mm_or_si128(_mm_set1_epi32(0x7c00), payload),
+		_mm_and_si128(_mm_cmpeq_epi32(payload, _mm_setzero_si128()), _mm_set1_epi32(1)));
+
+	__m128i isNormal = _mm_cmpgt_epi32(absolute, _mm_set1_epi32(((127 - 14) << 23) - 1));
+	__m128i isNaN = _mm_cmpgt_epi32(absolute, _mm_set1_epi32(0x7f800000));
+	__m128i half = _mm_or_si128(_mm_and_si128(isNormal, normal), _mm_andnot_si128(isNormal, subnormal));
+	half = _mm_or_si128(_mm_and_si128(isNaN, nan), _mm_andnot_si128(isNaN, half));
+	return _mm_or_si128(half, sign);
+}
+
+// Round four floats, all of magnitude below 2^31, to the nearest integers, half away from zero.
+static __m128i roundAway(__m128 f)
+{
+	__m128i truncated = _mm_cvttps_epi32(f);
+	__m128 fraction = _mm_sub_ps(f, _mm_cvtepi32_ps(truncated));
+	__m128i up = _mm_castps_si128(_mm_cmpge_ps(fraction, _mm_set1_ps(0.5f))); // -1 where true.
+	__m128i down = _mm_castps_si128(_mm_cmple_ps(fraction, _mm_set1_ps(-0.5f)));
+	return _mm_add_epi32(_mm_sub_epi32(truncated, up), down);
+}
+
+void packHalf(const float* in, unsigned short* out, int count)
+{
+	int i = 0;
+	for (; i + 8 <= count; i += 8)
+	{
+		// Sign extend the halves so that the saturating pack keeps their bits.
+		__m128i low = floatToHalf(_mm_loadu_ps(in + i)), high = floatToHalf(_mm_loadu_ps(in + i + 4));
+		low = _mm_srai_epi32(_mm_slli_epi32(low, 16), 16);
+		high = _mm_srai_epi32(_mm_slli_epi32(high, 16), 16);
+		_mm_storeu_si128((__m128i*)(out + i), _mm_packs_epi32(low, high));
+	}
+	for (; i < count; i++)
+		out[i] = glm::packHalf1x16(in[i]);
+}
+
+void unpackHalf(const unsigned short* in, float* out, int count)
+{
+	int i = 0;
+	for (; i + 8 <= count; i += 8)
+	{
+		__m128i halves = _mm_loadu_si128((const __m128i*)(in + i));
+		__m128i parts[2] = { _mm_unpacklo_epi16(halves, _mm_setzero_si128()), _mm_unpackhi_epi16(halves, _mm_setzero_si128()) };
+		for (int k = 0; k < 2; k++)
+		{
+			// Moved into place, the exponent and mantissa are the float 2^-112 times too small,
+			// which one multiplication corrects, subnormals included. Infinities and NaNs get the
+			// largest exponent instead.
+			__m128i magnitude = _mm_and_si128(parts[k], _mm_set1_epi32(0x7fff));
+			__m128i sign = _mm_slli_epi32(_mm_xor_si128(parts[k], magnitude), 16);
+			__m128 scaled = _mm_mul_ps(_mm_castsi128_ps(_mm_slli_epi32(magnitude, 13)),
+				_mm_castsi128_ps(_mm_set1_epi32((254 - 15) << 23)));
+			__m128i isSpecial = _mm_cmpgt_epi32(magnitude, _mm_set1_epi32(0x7bff));
+			__m128i special = _mm_and_si128(isSpecial, _mm_set1_epi32(255 << 23));
+			_mm_storeu_ps(out + i + 4 * k, _mm_or_ps(scaled, _mm_castsi128_ps(_mm_or_si128(sign, special))));
+		}
+	}
+	for (; i < count; i++)
+		out[i] = glm::unpackHalf1x16(in[i]);
+}
+
+void packUnorm8(const float* in, unsigned char* out, int count)
+{
+	int i = 0;
+	for (; i + 16 <= count; i += 16)
+	{
+		__m128i words[4];
+		for (int k = 0; k < 4; k++)
+		{
+			__m128 clamped = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(in + i + 4 * k), _mm_setzero_ps()), _mm_set1_ps(1.0f));
+			words[k] = roundAway(_mm_mul_ps(clamped, _mm_set1_ps(255.0f)));
+		}
+		__m128i shorts = _mm_packs_epi32(words[0], words[1]), moreShorts = _mm_packs_epi32(words[2], words[3]);
+		_mm_storeu_si128((__m128i*)(out + i), _mm_packus_epi16(shorts, moreShorts));
+	}
+	for (; i < count; i++)
+		out[i] = glm::packUnorm1x8(in[i]);
+}
+
+void unpackUnorm8(const unsigned char* in, float* out, int count)
+{
+	int i = 0;
+	for (; i + 16 <= count; i += 16)
+	{
+		__m128i bytes = _mm_loadu_si128((const __m128i*)(in + i));
+		__m128i shorts[2] = { _mm_unpacklo_epi8(bytes, _mm_setzero_si128()), _mm_unpackhi_epi8(bytes, _mm_setzero_si128()) };
+		for (int k = 0; k < 4; k++)
+		{
+			__m128i words = k % 2 == 0 ? _mm_unpacklo_epi16(shorts[k / 2], _mm_setzero_si128())
+				: _mm_unpackhi_epi16(shorts[k / 2], _mm_setzero_si128());
+			_mm_storeu_ps(out + i + 4 * k, _mm_mul_ps(_mm_cvtepi32_ps(words), _mm_set1_ps(0.0039215686274509803921568627451f)));
+		}
+	}
+	for (; i < count; i++)
+		out[i] = glm::unpackUnorm1x8(in[i]);
+}
+
+void packSnorm16(const float* in, short* out, int count)
+{
+	int i = 0;
+	for (; i + 8 <= count; i += 8)
+	{
+		__m128i words[2];
+		for (int k = 0; k < 2; k++)
+		{
+			__m128 clamped = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(in + i + 4 * k), _mm_set1_ps(-1.0f)), _mm_set1_ps(1.0f));
+			words[k] = roundAway(_mm_mul_ps(clamped, _mm_set1_ps(32767.0f)));
+		}
+		_mm_storeu_si128((__m128i*)(out + i), _mm_packs_epi32(words[0], words[1]));
+	}
+	for (; i < count; i++)
+		out[i] = (short)glm::packSnorm1x16(in[i]);
+}
+
+void unpackSnorm16(const short* in, float* out, int count)
+{
+	int i = 0;
+	for (; i + 8 <= count; i += 8)
+	{
+		// Sign extend each short into its lane.
+		__m128i shorts = _mm_loadu_si128((const __m128i*)(in + i));
+		__m128i words[2] = { _mm_srai_epi32(_mm_unpacklo_epi16(shorts, shorts), 16),
+			_mm_srai_epi32(_mm_unpackhi_epi16(shorts, shorts), 16) };
+		for (int k = 0; k < 2; k++)
+		{
+			__m128 scaled = _mm_mul_ps(_mm_cvtepi32_ps(words[k]), _mm_set1_ps(3.0518509475997192297128208258309e-5f));
+			_mm_storeu_ps(out + i + 4 * k, _mm_min_ps(_mm_max_ps(scaled, _mm_set1_ps(-1.0f)), _mm_set1_ps(1.0f)));
+		}
+	}
+	for (; i < count; i++)
+		out[i] = min(max(in[i] * 3.0518509475997192297128208258309e-5f, -1.0f), 1.0f);
+}
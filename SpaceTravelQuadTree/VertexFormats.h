@@ -0,0 +1,50 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <vector>
+
+using namespace std;
+
+#define INSTANCE_CELL_SIZE 32.0f // Instance positions are stored relative to the corner of the
+                                 // cell of the grid of this size that the camera is in.
+
+// How the vertices of a mesh are stored in its buffer.
+enum MeshFormat
+{
+	MESH_FORMAT_FLOAT, // x, y, z as floats: 12 bytes.
+	MESH_FORMAT_SNORM16, // x, y, z over the mesh's largest coordinate as snorm16, and a pad: 8 bytes.
+};
+
+// How the instances of an instanced batch are stored in their buffer: the transform of every
+// instance, x, y, z relative to an origin and its turn about y in degrees, followed by the color
+// of every instance.
+enum InstanceFormat
+{
+	INSTANCE_FORMAT_FLOAT, // Transform and RGBA color as floats: 32 bytes an instance.
+	INSTANCE_FORMAT_PACKED, // Transform as halves and color as RGBA8: 12 bytes an instance.
+};
+
+// Bytes an instance takes in format.
+int getInstanceSize(InstanceFormat format);
+
+// Offset of the first color in a buffer of count instances in format.
+int getInstanceColorOffset(InstanceFormat format, int count);
+
+// Store count vertices in format into data, setting scale to what the stored coordinates must be
+// multiplied by.
+void encodeMesh(const glm::vec3* vertices, int count, MeshFormat format, vector<unsigned char>& data, float& scale);
+
+// Store count instances in format into data, from four floats of transform and four bytes of RGBA
+// color each.
+void encodeInstances(const float* transforms, const unsigned char* colors, int count, InstanceFormat format,
+	vector<unsigned char>& data);
+
+// Bulk converters, four values at a time with SSE2. Each gives the same bits as the glm function
+// of gtc/packing for one value whose name it shares, for finite inputs, except that glm's
+// unpackSnorm1x16 reads negative values as unsigned where unpackSnorm16 sign extends them.
+void packHalf(const float* in, unsigned short* out, int count); // packHalf1x16
+void unpackHalf(const unsigned short* in, float* out, int count); // unpackHalf1x16
+void packUnorm8(const float* in, unsigned char* out, int count); // packUnorm1x8
+void unpackUnorm8(const unsigned char* in, float* out, int count); // unpackUnorm1x8
+void packSnorm16(const float* in, short* out, int count); // packSnorm1x16
+void unpackSnorm16(const short* in, float* out, int count); // unpackSnorm1x16
@@ -0,0 +1,79 @@
+#include <glm/gtc/type_ptr.hpp>
+
+#include "VisibilityCache.h"
+#include "AsteroidField.h"
+#include "Profiler.h"
+#include "collisionDetectionRoutines.h"
+
+void VisibilityCache::query(AsteroidField& field, const glm::mat4& viewProjection, vector<int>& visible)
+{
+	Profiler& profiler = Profiler::getInstance();
+	float planes[6][4];
+	extractFrustumPlanes(glm::value_ptr(viewProjection), planes);
+
+	if (isValid && revision == field.getRevision() && viewProjection == this->viewProjection)
+		profiler.addCounter("visibility cache hits", 1);
+	else if (isValid && revision == field.getRevision() && isInside(field, planes))
+	{
+		profiler.addCounter("visibility cache updates", 1);
+		profiler.addCounter("visibility candidates retested", (double)candidates.size());
+		this->viewProjection = viewProjection;
+		test(field, planes);
+	}
+	else
+	{
+		profiler.addCounter("visibility cache misses", 1);
+		isValid = true;
+		revision = field.getRevision();
+		this->viewProjection = viewProjection;
+		for (int p = 0; p < 6; p++)
+		{
+			for (int k = 0; k < 4; k++)
+				expanded[p][k] = planes[p][k];
+			expanded[p][3] += VISIBILITY_MARGIN;
+		}
+		candidates.clear();
+		field.getBVH().queryFrustum(expanded, candidates, SPHERE_SIZE);
+		test(field, planes);
+	}
+
+	visible.insert(visible.end(), this->visible.begin(), this->visible.end());
+}
+
+// Whether every asteroid the frustum of planes may report is among the candidates. The hierarchy
+// keeps a sphere unless its center is further than its drawn radius outside one of the planes, so
+// the frustum with its planes moved out by the largest drawn radius must be inside the expanded
+// one: its corners, each where a side, a top or bottom and the near or far plane meet, must be.
+bool VisibilityCache::isInside(AsteroidField& field, const float planes[6][4])
+{
+	float radius = max(field.getLargestRadius(), (float)SPHERE_SIZE);
+	for (int corner = 0; corner < 8; corner++)
+	{
+		const float* a = planes[corner & 1];
+		const float* b = planes[2 + (corner >> 1 & 1)];
+		const float* c = planes[4 + (corner >> 2)];
+		glm::mat3 normals(a[0], b[0], c[0], a[1], b[1], c[1], a[2], b[2], c[2]); // Rows are the normals.
+		glm::vec3 point = glm::inverse(normals) * -glm::vec3(a[3] + radius, b[3] + radius, c[3] + radius);
+
+		for (int p = 0; p < 6; p++)
+			if (expanded[p][0] * point.x + expanded[p][1] * point.y + expanded[p][2] * point.z + expanded[p][3] < 0)
+				return false;
+	}
+	return true;
+}
+
+// Keep the candidates in the frustum of planes, with the test of AsteroidBVH::queryFrustum.
+void VisibilityCache::test(AsteroidField& field, const float planes[6][4])
+{
+	visible.clear();
+	for (int id : candidates)
+	{
+		Asteroid& asteroid = field.get(id);
+		float x = asteroid.getCenterX(), y = asteroid.getCenterY(), z = asteroid.getCenterZ();
+		float r = max(asteroid.getRadius(), (float)SPHERE_SIZE); // The mesh is drawn at SPHERE_SIZE whatever the radius.
+		bool inside = true;
+		for (int p = 0; p < 6 && inside; p++)
+			inside = planes[p][0] * x + planes[p][1] * y + planes[p][2] * z + planes[p][3] >= -r;
+		if (inside) visible.push_back(id);
+	}
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <vector>
+
+using namespace std;
+
+class AsteroidField;
+
+#define VISIBILITY_MARGIN 20.0f // How far outside the frustum asteroids are kept as candidates.
+
+// Frustum culling for one camera that reuses the last frame's work. The asteroids found in the
+// frustum are kept with the camera that saw them and given again while neither the camera nor
+// the field changes. The query also keeps as candidates the asteroids within VISIBILITY_MARGIN
+// of the frustum, so that when the camera moves a little, and its frustum stays inside the one
+// the candidates were found in, only the candidates are tested again instead of the hierarchy.
+class VisibilityCache
+{
+public:
+	// Put in visible the asteroids of field whose drawn mesh may be in the frustum of
+	// viewProjection, the same ones and in the same order as AsteroidBVH::queryFrustum would with
+	// SPHERE_SIZE as the least radius.
+	void query(AsteroidField& field, const glm::mat4& viewProjection, vector<int>& visible);
+
+private:
+	bool isValid = false;
+	unsigned int revision; // Of the field the candidates were found in.
+	glm::mat4 viewProjection; // That the candidates were found with, and found visible for.
+	float expanded[6][4]; // Planes of that frustum moved out by VISIBILITY_MARGIN.
+	vector<int> candidates, visible;
+
+	bool isInside(AsteroidField& field, const float planes[6][4]);
+	void test(AsteroidField& field, const float planes[6][4]);
+};
@@ -0,0 +1,162 @@
+#include <algorithm>
+#include <cmath>
+#include <emmintrin.h>
+
+#include "collisionDetectionRoutines.h"
+
+using namespace std;
+
+// Return 1 if the spheres centered at (x1,y1,z1) and (x2,y2,z2) with radius r1 and r2
+// intersect, otherwise return 0.
+int checkSpheresIntersection(float x1, float y1, float z1, float r1,
+	float x2, float y2, float z2, float r2)
+{
+	return ((x1 - x2)*(x1 - x2) + (y1 - y2)*(y1 - y2) + (z1 - z2)*(z1 - z2) <= (r1 + r2)*(r1 + r2));
+}
+
+// A sphere of radius r1 moves with its center going from (x0,y0,z0) to (x1,y1,z1). Return the
+// fraction t in [0,1] of the motion at which it first touches the static sphere centered at
+// (x2,y2,z2) of radius r2, or -1 if it does not touch it at all.
+float sweptSpheresTimeOfImpact(float x0, float y0, float z0, float x1, float y1, float z1, float r1,
+	float x2, float y2, float z2, float r2)
+{
+	// The centers are at distance r1 + r2 when |m + t d| = r1 + r2, with m the start offset
+	// between the centers and d the motion, i.e. when a t^2 + 2 b t + c = 0.
+	float mx = x0 - x2, my = y0 - y2, mz = z0 - z2;
+	float dx = x1 - x0, dy = y1 - y0, dz = z1 - z0;
+	float a = dx*dx + dy*dy + dz*dz;
+	float b = mx*dx + my*dy + mz*dz;
+	float c = mx*mx + my*my + mz*mz - (r1 + r2)*(r1 + r2);
+
+	// Not moving, or moving away from the static sphere.
+	if (b >= 0) return -1;
+
+	// Already overlapping and moving closer.
+	if (c <= 0) return 0;
+
+	// The path of the center misses the grown sphere.
+	float discriminant = b*b - a*c;
+	if (discriminant < 0) return -1;
+
+	float t = (-b - sqrt(discriminant)) / a;
+	if (t > 1) return -1;
+	return t;
+}
+
+// Batched version of sweptSpheresTimeOfImpact over n static spheres.
+void sweptSpheresTimeOfImpact(float x0, float y0, float z0, float x1, float y1, float z1, float r1,
+	const float* x2, const float* y2, const float* z2, const float* r2, int n, float* t)
+{
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128 none = _mm_set1_ps(-1.0f);
+	const __m128 dx = _mm_set1_ps(x1 - x0), dy = _mm_set1_ps(y1 - y0), dz = _mm_set1_ps(z1 - z0);
+	const __m128 a = _mm_set1_ps((x1 - x0)*(x1 - x0) + (y1 - y0)*(y1 - y0) + (z1 - z0)*(z1 - z0));
+
+	int i = 0;
+	for (; i + 4 <= n; i += 4)
+	{
+		__m128 mx = _mm_sub_ps(_mm_set1_ps(x0), _mm_loadu_ps(x2 + i));
+		__m128 my = _mm_sub_ps(_mm_set1_ps(y0), _mm_loadu_ps(y2 + i));
+		__m128 mz = _mm_sub_ps(_mm_set1_ps(z0), _mm_loadu_ps(z2 + i));
+		__m128 rr = _mm_add_ps(_mm_set1_ps(r1), _mm_loadu_ps(r2 + i));
+
+		__m128 b = _mm_add_ps(_mm_add_ps(_mm_mul_ps(mx, dx), _mm_mul_ps(my, dy)), _mm_mul_ps(mz, dz));
+		__m128 c = _mm_sub_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(mx, mx), _mm_mul_ps(my, my)), _mm_mul_ps(mz, mz)),
+			_mm_mul_ps(rr, rr));
+		__m128 discriminant = _mm_sub_ps(_mm_mul_ps(b, b), _mm_mul_ps(a, c));
+		__m128 root = _mm_div_ps(_mm_sub_ps(_mm_sub_ps(zero, b), _mm_sqrt_ps(_mm_max_ps(discriminant, zero))), a);
+
+		// Same cases as the scalar routine, selected with masks instead of branches.
+		__m128 approaching = _mm_cmplt_ps(b, zero);
+		__m128 overlapping = _mm_cmple_ps(c, zero);
+		__m128 hit = _mm_and_ps(_mm_cmpge_ps(discriminant, zero), _mm_cmple_ps(root, one));
+
+		__m128 result = _mm_or_ps(_mm_and_ps(hit, root), _mm_andnot_ps(hit, none));
+		result = _mm_andnot_ps(overlapping, result); // overlapping gives 0
+		result = _mm_or_ps(_mm_and_ps(approaching, result), _mm_andnot_ps(approaching, none));
+		_mm_storeu_ps(t + i, result);
+	}
+
+	for (; i < n; i++)
+		t[i] = sweptSpheresTimeOfImpact(x0, y0, z0, x1, y1, z1, r1, x2[i], y2[i], z2[i], r2[i]);
+}
+
+// Return the distance from the point (px,py,pz) to the solid cone with apex (ax,ay,az) and
+// circular base of radius r centered at (bx,by,bz), or 0 if the point is inside the cone.
+float pointConeDistance(float px, float py, float pz,
+	float ax, float ay, float az, float bx, float by, float bz, float r)
+{
+	// Work in the half-plane through the axis containing the point, with coordinates h along
+	// the axis from the base and q away from it. There the cone is the triangle (0,0), (0,r),
+	// (height,0).
+	float ux = ax - bx, uy = ay - by, uz = az - bz;
+	float height = sqrt(ux*ux + uy*uy + uz*uz);
+	ux /= height; uy /= height; uz /= height;
+
+	float wx = px - bx, wy = py - by, wz = pz - bz;
+	float h = wx*ux + wy*uy + wz*uz;
+	float q = sqrt(max(wx*wx + wy*wy + wz*wz - h*h, 0.0f));
+
+	if (h >= 0 && h <= height && q <= r * (1 - h / height)) return 0;
+
+	// Outside, the nearest point is on the base edge or on the slanted edge.
+	float dq = q - min(q, r);
+	float baseDistance = sqrt(h*h + dq*dq);
+
+	float sh = height, sq = -r; // slanted edge from (0,r) to (height,0)
+	float s = min(max((h*sh + (q - r)*sq) / (sh*sh + sq*sq), 0.0f), 1.0f);
+	float eh = h - s*sh, eq = q - r - s*sq;
+	float slantDistance = sqrt(eh*eh + eq*eq);
+
+	return min(baseDistance, slantDistance);
+}
+
+// Return 1 if the solid cone with apex (ax,ay,az) and base of radius r1 centered at (bx,by,bz)
+// intersects the sphere centered at (x2,y2,z2) of radius r2, otherwise return 0.
+int checkConeSphereIntersection(float ax, float ay, float az, float bx, float by, float bz, float r1,
+	float x2, float y2, float z2, float r2)
+{
+	return pointConeDistance(x2, y2, z2, ax, ay, az, bx, by, bz, r1) <= r2;
+}
+
+// Batched version of checkSpheresIntersection over n pairs of spheres.
+void checkSpheresIntersection(const float* x1, const float* y1, const float* z1, const float* r1,
+	const float* x2, const float* y2, const float* z2, const float* r2, int n, char* hit)
+{
+	int i = 0;
+	for (; i + 4 <= n; i += 4)
+	{
+		__m128 dx = _mm_sub_ps(_mm_loadu_ps(x1 + i), _mm_loadu_ps(x2 + i));
+		__m128 dy = _mm_sub_ps(_mm_loadu_ps(y1 + i), _mm_loadu_ps(y2 + i));
+		__m128 dz = _mm_sub_ps(_mm_loadu_ps(z1 + i), _mm_loadu_ps(z2 + i));
+		__m128 rr = _mm_add_ps(_mm_loadu_ps(r1 + i), _mm_loadu_ps(r2 + i));
+		__m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+
+		int mask = _mm_movemask_ps(_mm_cmple_ps(distance, _mm_mul_ps(rr, rr)));
+		hit[i] = mask & 1;
+		hit[i + 1] = (mask >> 1) & 1;
+		hit[i + 2] = (mask >> 2) & 1;
+		hit[i + 3] = (mask >> 3) & 1;
+	}
+
+	for (; i < n; i++)
+		hit[i] = checkSpheresIntersection(x1[i], y1[i], z1[i], r1[i], x2[i], y2[i], z2[i], r2[i]);
+}
+
+// Extract the six planes of the view frustum of the column-major 4x4 matrix m.
+void extractFrustumPlanes(const float* m, float planes[6][4])
+{
+	// Each plane is the last row of the matrix plus or minus one of the other rows.
+	for (int p = 0; p < 6; p++)
+	{
+		int row = p / 2;
+		float sign = (p % 2) ? -1.0f : 1.0f;
+		for (int k = 0; k < 4; k++)
+			planes[p][k] = m[4 * k + 3] + sign * m[4 * k + row];
+
+		float length = sqrt(planes[p][0] * planes[p][0] + planes[p][1] * planes[p][1] + planes[p][2] * planes[p][2]);
+		for (int k = 0; k < 4; k++)
+			planes[p][k] /= length;
+	}
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+///////////////////////////////////////////////////////////////////////////////////////////////
+// collisionDetectionRoutines.cpp
+//
+// Routines to check for collision between bounding volumes in 3D, both at a fixed position
+// and swept along a straight line motion segment.
+///////////////////////////////////////////////////////////////////////////////////////////////
+
+// Return 1 if the spheres centered at (x1,y1,z1) and (x2,y2,z2) with radius r1 and r2
+// intersect, otherwise return 0.
+int checkSpheresIntersection(float x1, float y1, float z1, float r1,
+	float x2, float y2, float z2, float r2);
+
+// A sphere of radius r1 moves with its center going from (x0,y0,z0) to (x1,y1,z1). Return the
+// fraction t in [0,1] of the motion at which it first touches the static sphere centered at
+// (x2,y2,z2) of radius r2, or -1 if it does not touch it at all. Spheres that already overlap
+// return 0 if they move closer and -1 if they move apart, so a touching sphere is never stuck.
+float sweptSpheresTimeOfImpact(float x0, float y0, float z0, float x1, float y1, float z1, float r1,
+	float x2, float y2, float z2, float r2);
+
+// Batched version of sweptSpheresTimeOfImpact: test the moving sphere against the n static
+// spheres given as separate arrays of centers and radii, writing each time of impact (or -1)
+// into t. Four spheres are tested at once with SSE.
+void sweptSpheresTimeOfImpact(float x0, float y0, float z0, float x1, float y1, float z1, float r1,
+	const float* x2, const float* y2, const float* z2, const float* r2, int n, float* t);
+
+// Return the distance from the point (px,py,pz) to the solid cone with apex (ax,ay,az) and
+// circular base of radius r centered at (bx,by,bz), or 0 if the point is inside the cone.
+float pointConeDistance(float px, float py, float pz,
+	float ax, float ay, float az, float bx, float by, float bz, float r);
+
+// Return 1 if the solid cone with apex (ax,ay,az) and base of radius r1 centered at (bx,by,bz)
+// intersects the sphere centered at (x2,y2,z2) of radius r2, otherwise return 0.
+int checkConeSphereIntersection(float ax, float ay, float az, float bx, float by, float bz, float r1,
+	float x2, float y2, float z2, float r2);
+
+// Batched version of checkSpheresIntersection over n pairs of spheres given as separate arrays
+// of centers and radii, writing 1 into hit[i] if the i-th pair intersects and 0 otherwise. Four
+// pairs are tested at once with SSE.
+void checkSpheresIntersection(const float* x1, const float* y1, const float* z1, const float* r1,
+	const float* x2, const float* y2, const float* z2, const float* r2, int n, char* hit);
+
+// Extract the six planes (a, b, c, d) of the view frustum of the column-major 4x4 matrix m, the
+// product of a projection and a view matrix, in the order left, right, bottom, top, near, far.
+// Points inside the frustum have a x + b y + c z + d >= 0 for every plane, and the normals
+// (a, b, c) have unit length.
+void extractFrustumPlanes(const float* m, float planes[6][4]);
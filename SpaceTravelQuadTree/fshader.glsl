@@ -1,6 +1,17 @@
 #version 120
+// Impostors are shaded as the sphere they stand for, lit from the camera, inside the circle
+// inscribed in their quad.
+uniform float impostor;
+varying vec2 impostorCorner;
+
 void
 main()
 {
 	gl_FragColor = gl_Color;
+	if (impostor > 0.5)
+	{
+		float r2 = dot(impostorCorner, impostorCorner);
+		if (r2 >= 1.0) discard;
+		gl_FragColor.rgb *= 0.3 + 0.7 * sqrt(1.0 - r2);
+	}
 }
\ No newline at end of file
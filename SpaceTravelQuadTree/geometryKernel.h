@@ -0,0 +1,354 @@
+#pragma once
+
+#include <cmath>
+#include <limits>
+
+#include <glm/glm.hpp>
+
+///////////////////////////////////////////////////////////////////////////////////////////////
+// geometryKernel.h
+//
+// Header-only kernel of 2D predicates and intersection tests behind the routines of
+// intersectionDetectionRoutines, templated on the scalar type so that they inline into their
+// callers. Routines that only compare and multiply are constexpr, and checked at compile time
+// at the end of this file. Every decision on which side of a line a point lies is made with
+// orientationSign, which is exact: it only falls back on exact arithmetic when the determinant
+// evaluated in the given precision is too close to 0 to be trusted.
+///////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace geometry
+{
+	// Return determinant of a 2x2 matrix with elements input in row-major order.
+	template<typename T>
+	constexpr T det2(T a11, T a12, T a21, T a22)
+	{
+		return a11*a22 - a12*a21;
+	}
+
+	// Return determinant of a 3x3 matrix with elements input in row-major order.
+	template<typename T>
+	constexpr T det3(T a11, T a12, T a13, T a21, T a22, T a23, T a31, T a32, T a33)
+	{
+		return a11*a22*a33 - a11*a23*a32 + a12*a23*a31 - a12*a21*a33 + a13*a21*a32 - a13*a22*a31;
+	}
+
+	// Return det3(x1, y1, 1, x2, y2, 1, x3, y3, 1), twice the signed area of the triangle
+	// (x1,y1), (x2,y2), (x3,y3), evaluated in T.
+	template<typename T>
+	constexpr T orientation(T x1, T y1, T x2, T y2, T x3, T y3)
+	{
+		return (x2 - x1) * (y3 - y1) - (y2 - y1) * (x3 - x1);
+	}
+
+	// Return the smallest of four numbers.
+	template<typename T>
+	constexpr T min4(T a, T b, T c, T d)
+	{
+		return (a < b ? a : b) < (c < d ? c : d) ? (a < b ? a : b) : (c < d ? c : d);
+	}
+
+	// Return the largest of four numbers.
+	template<typename T>
+	constexpr T max4(T a, T b, T c, T d)
+	{
+		return (a > b ? a : b) > (c > d ? c : d) ? (a > b ? a : b) : (c > d ? c : d);
+	}
+
+	// Set s + e to exactly a + b, with s the rounded sum (Knuth's two-sum).
+	inline void twoSum(double a, double b, double& s, double& e)
+	{
+		s = a + b;
+		double bVirtual = s - a, aVirtual = s - bVirtual;
+		e = (a - aVirtual) + (b - bVirtual);
+	}
+
+	// Set p + e to exactly a * b, with p the rounded product.
+	inline void twoProduct(double a, double b, double& p, double& e)
+	{
+		p = a * b;
+		e = std::fma(a, b, -p);
+	}
+
+	// Add b to the expansion e of length components, non-overlapping and in increasing order of
+	// magnitude, keeping it so and dropping zero components (Shewchuk's grow-expansion).
+	inline void growExpansion(double* e, int& length, double b)
+	{
+		double q = b, h;
+		int n = 0;
+		for (int i = 0; i < length; i++)
+		{
+			twoSum(q, e[i], q, h);
+			if (h != 0) e[n++] = h;
+		}
+		if (q != 0) e[n++] = q;
+		length = n;
+	}
+
+	// Sign of orientation(x1, y1, x2, y2, x3, y3) computed exactly: every difference is kept as a
+	// rounded value and its error, and the 16 partial products summed as an expansion, the sign
+	// of which is that of its largest component.
+	inline int exactOrientationSign(double x1, double y1, double x2, double y2, double x3, double y3)
+	{
+		double a[2], b[2], c[2], d[2];
+		twoSum(x2, -x1, a[0], a[1]);
+		twoSum(y3, -y1, b[0], b[1]);
+		twoSum(y2, -y1, c[0], c[1]);
+		twoSum(x3, -x1, d[0], d[1]);
+
+		double expansion[16], p, e;
+		int length = 0;
+		for (int i = 0; i < 2; i++)
+			for (int j = 0; j < 2; j++)
+			{
+				twoProduct(a[i], b[j], p, e);
+				growExpansion(expansion, length, e);
+				growExpansion(expansion, length, p);
+				twoProduct(-c[i], d[j], p, e);
+				growExpansion(expansion, length, e);
+				growExpansion(expansion, length, p);
+			}
+
+		if (length == 0) return 0;
+		return expansion[length - 1] > 0 ? 1 : -1;
+	}
+
+	// Return 1 if (x3,y3) lies to the left of the directed line from (x1,y1) to (x2,y2), -1 if it
+	// lies to the right, and 0 if the three points are collinear. The determinant is first
+	// evaluated in T, and only if it is within its rounding error bound of 0 is the sign
+	// computed exactly.
+	template<typename T>
+	inline int orientationSign(T x1, T y1, T x2, T y2, T x3, T y3)
+	{
+		T left = (x2 - x1) * (y3 - y1), right = (y2 - y1) * (x3 - x1);
+		T det = left - right;
+
+		// Error bound of the evaluation in T (Shewchuk's ccwerrboundA), epsilon being half an ulp of 1.
+		const T epsilon = std::numeric_limits<T>::epsilon() / 2;
+		T bound = (3 + 16 * epsilon) * epsilon * (std::fabs(left) + std::fabs(right));
+
+		if (det > bound) return 1;
+		if (-det > bound) return -1;
+		return exactOrientationSign(x1, y1, x2, y2, x3, y3);
+	}
+
+	// Given three collinear points (x1,y1) and (x2,y2) and (x3,y3) return 0 if (x3,y3) lies
+	// in the segment joining (x1,y1) and (x2,y2), -1 if it lies on one side, and 1 if on the other.
+	template<typename T>
+	constexpr int checkPointWRTSegment(T x1, T y1, T x2, T y2, T x3, T y3)
+	{
+		// Compare along x unless the segment is vertical.
+		return x1 < x2 ? (x3 < x1 ? -1 : (x3 > x2 ? 1 : 0)) :
+			x2 < x1 ? (x3 < x2 ? -1 : (x3 > x1 ? 1 : 0)) :
+			y1 < y2 ? (y3 < y1 ? -1 : (y3 > y2 ? 1 : 0)) :
+			(y3 < y2 ? -1 : (y3 > y1 ? 1 : 0));
+	}
+
+	// Return 1 if the segment joining (x1,y1) and (x2,y2) intersects the segment joining (x3,y3)
+	// and (x4,y4), otherwise return 0.
+	template<typename T>
+	inline int checkSegmentsIntersection(T x1, T y1, T x2, T y2, T x3, T y3, T x4, T y4)
+	{
+		int o1 = orientationSign(x1, y1, x2, y2, x3, y3), o2 = orientationSign(x1, y1, x2, y2, x4, y4);
+
+		// All four points are collinear, in which case they do not intersect if (x3,y3) and
+		// (x4,y4) both lie on the same side of the segment joining (x1,y1) and (x2,y2).
+		if (o1 == 0 && o2 == 0)
+		{
+			int s3 = checkPointWRTSegment(x1, y1, x2, y2, x3, y3), s4 = checkPointWRTSegment(x1, y1, x2, y2, x4, y4);
+			return (s3 == 1 && s4 == 1) || (s3 == -1 && s4 == -1) ? 0 : 1;
+		}
+
+		// Otherwise they intersect if (x3,y3) and (x4,y4) do not both lie strictly on the same side
+		// of the line through (x1,y1) and (x2,y2), and (x1,y1) and (x2,y2) do not both lie strictly
+		// on the same side of the line through (x3,y3) and (x4,y4).
+		if (o1 * o2 > 0) return 0;
+		return orientationSign(x3, y3, x4, y4, x1, y1) * orientationSign(x3, y3, x4, y4, x2, y2) > 0 ? 0 : 1;
+	}
+
+	// Return 1 if the point (x5,y5) lies in the quadrilateral with vertices at (x1,y1), (x2,y2),
+	// (x3,y3) and (x4,y4), i.e., if it is on the same side of all four of its sides, otherwise
+	// return 0.
+	template<typename T>
+	inline int checkPointInQuadrilateral(T x1, T y1, T x2, T y2, T x3, T y3, T x4, T y4, T x5, T y5)
+	{
+		int o1 = orientationSign(x1, y1, x2, y2, x5, y5);
+		int o2 = orientationSign(x2, y2, x3, y3, x5, y5);
+		int o3 = orientationSign(x3, y3, x4, y4, x5, y5);
+		int o4 = orientationSign(x4, y4, x1, y1, x5, y5);
+		return (o1 >= 0 && o2 >= 0 && o3 >= 0 && o4 >= 0) || (o1 <= 0 && o2 <= 0 && o3 <= 0 && o4 <= 0);
+	}
+
+	// Given the vertices (x[i],y[i]) of a quadrilateral return 1 if it is strictly convex with its
+	// vertices in counter-clockwise order, -1 if strictly convex in clockwise order, otherwise 0.
+	template<typename T>
+	inline int convexOrientation(const T* x, const T* y)
+	{
+		int o1 = orientationSign(x[0], y[0], x[1], y[1], x[2], y[2]);
+		int o2 = orientationSign(x[1], y[1], x[2], y[2], x[3], y[3]);
+		int o3 = orientationSign(x[2], y[2], x[3], y[3], x[0], y[0]);
+		int o4 = orientationSign(x[3], y[3], x[0], y[0], x[1], y[1]);
+		if (o1 > 0 && o2 > 0 && o3 > 0 && o4 > 0) return 1;
+		if (o1 < 0 && o2 < 0 && o3 < 0 && o4 < 0) return -1;
+		return 0;
+	}
+
+	// Return 1 if the quadrilateral with vertices at (x1,y1), (x2,y2), (x3,y3) and (x4,y4) is
+	// strictly convex, i.e., it turns the same way, and not straight, at all four vertices.
+	template<typename T>
+	inline int checkQuadrilateralConvex(T x1, T y1, T x2, T y2, T x3, T y3, T x4, T y4)
+	{
+		T x[4] = { x1, x2, x3, x4 }, y[4] = { y1, y2, y3, y4 };
+		return convexOrientation(x, y) != 0;
+	}
+
+	// Given a convex quadrilateral with vertices (x[i],y[i]) and orientation as returned by
+	// convexOrientation, return 1 if the line through one of its sides has all four points
+	// (px[k],py[k]) strictly on its outer side, otherwise return 0.
+	template<typename T>
+	inline int checkSeparatingSide(const T* x, const T* y, int orientation, const T* px, const T* py)
+	{
+		for (int i = 0; i < 4; i++)
+		{
+			// The outer side of a side of a counter-clockwise quadrilateral is its right; as the
+			// quadrilateral is convex it lies entirely on the inner side of the line through the side.
+			int j = (i + 1) % 4;
+			if (orientation * orientationSign(x[i], y[i], x[j], y[j], px[0], py[0]) < 0 &&
+				orientation * orientationSign(x[i], y[i], x[j], y[j], px[1], py[1]) < 0 &&
+				orientation * orientationSign(x[i], y[i], x[j], y[j], px[2], py[2]) < 0 &&
+				orientation * orientationSign(x[i], y[i], x[j], y[j], px[3], py[3]) < 0)
+				return 1;
+		}
+		return 0;
+	}
+
+	// Return 1 if the quadrilateral with vertices (x1,y1), (x2,y2), (x3,y3) and (x4,y4) intersects
+	// the quadrilateral with vertices at (x5,y5), (x6,y6), (x7,y7) and (x8,y8) (both assumed not
+	// self-intersecting), otherwise return 0. Works for any such quadrilaterals.
+	template<typename T>
+	inline int checkGeneralQuadrilateralsIntersection(T x1, T y1, T x2, T y2, T x3, T y3, T x4, T y4,
+		T x5, T y5, T x6, T y6, T x7, T y7, T x8, T y8)
+	{
+		// The boundaries of the two quadrilaterals intersect if one of the 16 pairs of sides,
+		// one from either quadrilateral, is intersecting.
+		T ax[4] = { x1, x2, x3, x4 }, ay[4] = { y1, y2, y3, y4 };
+		T bx[4] = { x5, x6, x7, x8 }, by[4] = { y5, y6, y7, y8 };
+		for (int i = 0; i < 4; i++)
+			for (int j = 0; j < 4; j++)
+				if (checkSegmentsIntersection(ax[i], ay[i], ax[(i + 1) % 4], ay[(i + 1) % 4],
+					bx[j], by[j], bx[(j + 1) % 4], by[(j + 1) % 4]))
+					return 1;
+
+		// If the boundaries do not intersect then the quadrilaterals intersect when one lies
+		// entirely within the other, which is the case if the vertex (x5,y5) lies in the first
+		// quadrilateral or the vertex (x1,y1) lies in the second.
+		return checkPointInQuadrilateral(x1, y1, x2, y2, x3, y3, x4, y4, x5, y5) ||
+			checkPointInQuadrilateral(x5, y5, x6, y6, x7, y7, x8, y8, x1, y1);
+	}
+
+	// Return 1 if the quadrilateral with vertices (x1,y1), (x2,y2), (x3,y3) and (x4,y4) intersects
+	// the quadrilateral with vertices at (x5,y5), (x6,y6), (x7,y7) and (x8,y8) (both assumed not
+	// self-intersecting), otherwise return 0. Quadrilaterals with bounding boxes apart are
+	// rejected first, and convex ones are tested on separating axes; only non-convex ones take
+	// the side-by-side test of checkGeneralQuadrilateralsIntersection.
+	template<typename T>
+	inline int checkQuadrilateralsIntersection(T x1, T y1, T x2, T y2, T x3, T y3, T x4, T y4,
+		T x5, T y5, T x6, T y6, T x7, T y7, T x8, T y8)
+	{
+		// Quadrilaterals whose bounding boxes are apart do not intersect.
+		if (max4(x1, x2, x3, x4) < min4(x5, x6, x7, x8) || max4(x5, x6, x7, x8) < min4(x1, x2, x3, x4) ||
+			max4(y1, y2, y3, y4) < min4(y5, y6, y7, y8) || max4(y5, y6, y7, y8) < min4(y1, y2, y3, y4))
+			return 0;
+
+		T ax[4] = { x1, x2, x3, x4 }, ay[4] = { y1, y2, y3, y4 };
+		T bx[4] = { x5, x6, x7, x8 }, by[4] = { y5, y6, y7, y8 };
+
+		// Sides of non-convex quadrilaterals do not make separating axes, so these take the general test.
+		int orientationA = convexOrientation(ax, ay), orientationB = convexOrientation(bx, by);
+		if (orientationA == 0 || orientationB == 0)
+			return checkGeneralQuadrilateralsIntersection(x1, y1, x2, y2, x3, y3, x4, y4, x5, y5, x6, y6, x7, y7, x8, y8);
+
+		// Two convex polygons are apart exactly when the other polygon lies entirely outside the
+		// line through one of their sides.
+		return !checkSeparatingSide(ax, ay, orientationA, bx, by) && !checkSeparatingSide(bx, by, orientationB, ax, ay);
+	}
+
+	// Return 1 if the axes-parallel rectangle with diagonally opposite corners at (x1,y1) and
+	// (x2,y2) intersects the disc centered (x3,y3) of radius r, otherwise return 0.
+	template<typename T>
+	constexpr int checkDiscRectangleIntersection(T x1, T y1, T x2, T y2, T x3, T y3, T r)
+	{
+		// The disc intersects the rectangle if its center lies in the strip with corners at
+		// (minX-r, minY) and (maxX+r, maxY), or if its center lies in the strip with corners
+		// at (minX, minY-r) and (maxX, maxY+r), or if its center is within distance r of one
+		// the four corners of the rectangles.
+		return ((x3 >= (x1 <= x2 ? x1 : x2) - r) && (x3 <= (x1 <= x2 ? x2 : x1) + r) &&
+				(y3 >= (y1 <= y2 ? y1 : y2)) && (y3 <= (y1 <= y2 ? y2 : y1))) ||
+			((x3 >= (x1 <= x2 ? x1 : x2)) && (x3 <= (x1 <= x2 ? x2 : x1)) &&
+				(y3 >= (y1 <= y2 ? y1 : y2) - r) && (y3 <= (y1 <= y2 ? y2 : y1) + r)) ||
+			(x3 - x1)*(x3 - x1) + (y3 - y1)*(y3 - y1) <= r*r ||
+			(x3 - x1)*(x3 - x1) + (y3 - y2)*(y3 - y2) <= r*r ||
+			(x3 - x2)*(x3 - x2) + (y3 - y2)*(y3 - y2) <= r*r ||
+			(x3 - x2)*(x3 - x2) + (y3 - y1)*(y3 - y1) <= r*r;
+	}
+
+	// Versions of the routines taking points as glm vectors.
+
+	template<typename T, glm::precision P>
+	inline T orientation(const glm::tvec2<T, P>& p1, const glm::tvec2<T, P>& p2, const glm::tvec2<T, P>& p3)
+	{
+		return orientation(p1.x, p1.y, p2.x, p2.y, p3.x, p3.y);
+	}
+
+	template<typename T, glm::precision P>
+	inline int orientationSign(const glm::tvec2<T, P>& p1, const glm::tvec2<T, P>& p2, const glm::tvec2<T, P>& p3)
+	{
+		return orientationSign(p1.x, p1.y, p2.x, p2.y, p3.x, p3.y);
+	}
+
+	template<typename T, glm::precision P>
+	inline int checkSegmentsIntersection(const glm::tvec2<T, P>& p1, const glm::tvec2<T, P>& p2,
+		const glm::tvec2<T, P>& p3, const glm::tvec2<T, P>& p4)
+	{
+		return checkSegmentsIntersection(p1.x, p1.y, p2.x, p2.y, p3.x, p3.y, p4.x, p4.y);
+	}
+
+	template<typename T, glm::precision P>
+	inline int checkPointInQuadrilateral(const glm::tvec2<T, P> quad[4], const glm::tvec2<T, P>& p)
+	{
+		return checkPointInQuadrilateral(quad[0].x, quad[0].y, quad[1].x, quad[1].y,
+			quad[2].x, quad[2].y, quad[3].x, quad[3].y, p.x, p.y);
+	}
+
+	template<typename T, glm::precision P>
+	inline int checkQuadrilateralsIntersection(const glm::tvec2<T, P> a[4], const glm::tvec2<T, P> b[4])
+	{
+		return checkQuadrilateralsIntersection(a[0].x, a[0].y, a[1].x, a[1].y, a[2].x, a[2].y, a[3].x, a[3].y,
+			b[0].x, b[0].y, b[1].x, b[1].y, b[2].x, b[2].y, b[3].x, b[3].y);
+	}
+
+	template<typename T, glm::precision P>
+	inline int checkDiscRectangleIntersection(const glm::tvec2<T, P>& corner1, const glm::tvec2<T, P>& corner2,
+		const glm::tvec2<T, P>& center, T r)
+	{
+		return checkDiscRectangleIntersection(corner1.x, corner1.y, corner2.x, corner2.y, center.x, center.y, r);
+	}
+
+	// Compile-time checks of the constexpr routines.
+	static_assert(det2(1.0f, 2.0f, 3.0f, 4.0f) == -2.0f, "det2 of a known matrix");
+	static_assert(det3(2.0, 0.0, 0.0, 0.0, 3.0, 0.0, 0.0, 0.0, 4.0) == 24.0, "det3 of a diagonal matrix");
+	static_assert(det3(1.0, 2.0, 1.0, 4.0, 5.0, 1.0, 7.0, 9.0, 1.0) == orientation(1.0, 2.0, 4.0, 5.0, 7.0, 9.0),
+		"orientation is det3 of the points with a column of ones");
+	static_assert(orientation(0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f) > 0, "left turn is positive");
+	static_assert(orientation(0.0f, 0.0f, 1.0f, 0.0f, 0.0f, -1.0f) < 0, "right turn is negative");
+	static_assert(orientation(0.0f, 0.0f, 1.0f, 1.0f, 3.0f, 3.0f) == 0, "collinear points");
+	static_assert(min4(3, 1, 4, 2) == 1 && max4(3, 1, 4, 2) == 4, "min4 and max4");
+	static_assert(checkPointWRTSegment(0.0f, 0.0f, 2.0f, 0.0f, 1.0f, 0.0f) == 0, "point in a segment");
+	static_assert(checkPointWRTSegment(2.0f, 0.0f, 0.0f, 0.0f, -1.0f, 0.0f) == -1, "point before a reversed segment");
+	static_assert(checkPointWRTSegment(0.0f, 0.0f, 0.0f, 2.0f, 0.0f, 3.0f) == 1, "point past a vertical segment");
+	static_assert(checkPointWRTSegment(0.0f, 2.0f, 0.0f, 0.0f, 0.0f, -1.0f) == -1, "point before a reversed vertical segment");
+	static_assert(checkDiscRectangleIntersection(0.0f, 0.0f, 2.0f, 2.0f, 1.0f, 1.0f, 0.5f), "disc inside");
+	static_assert(checkDiscRectangleIntersection(2.0f, 2.0f, 0.0f, 0.0f, 3.0f, 1.0f, 1.0f), "disc touching a side");
+	static_assert(checkDiscRectangleIntersection(0.0f, 0.0f, 2.0f, 2.0f, 3.0f, 3.0f, 1.5f), "disc over a corner");
+	static_assert(!checkDiscRectangleIntersection(0.0f, 0.0f, 2.0f, 2.0f, 3.0f, 3.0f, 1.0f), "disc off a corner");
+	static_assert(!checkDiscRectangleIntersection(0.0f, 0.0f, 2.0f, 2.0f, 5.0f, 1.0f, 1.0f), "disc beside");
+}
@@ -1,8 +1,7 @@
 
-#include <cstdlib>
-#include <cmath>
-#include <list>
-#include <iostream>
+#include <emmintrin.h>
+
+#include "intersectionDetectionRoutines.h"
 
 ///////////////////////////////////////////////////////////////////////////////////////////////     
 // intersectionDetectionRoutines.cpp
@@ -14,195 +13,166 @@
 // Sumanta Guha.
 ///////////////////////////////////////////////////////////////////////////////////////////////     
 
-// Return determinant of a 2x2 matrix with elements input in row-major order.
-float det2(float a11, float a12, float a21, float a22)
+// Lanes of a where mask is set, lanes of b elsewhere.
+static inline __m128 select(__m128 mask, __m128 a, __m128 b)
 {
-   return a11*a22 - a12*a21;
+   return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
 }
 
-// Return determinant of a 3x3 matrix with elements input in row-major order.
-float det3(float a11, float a12, float a13, float a21, float a22, 
-					 float a23, float a31, float a32, float a33)
+// 2x2 determinant of four lanes, as geometry::det2.
+static inline __m128 det2(__m128 a11, __m128 a12, __m128 a21, __m128 a22)
 {
-   return a11*a22*a33 - a11*a23*a32 + a12*a23*a31 - a12*a21*a33 + a13*a21*a32 - a13*a22*a31;
+   return _mm_sub_ps(_mm_mul_ps(a11, a22), _mm_mul_ps(a12, a21));
 }
 
-// Given three collinear points (x1,y1) and (x2,y2) and (x3,y3) return 0 if (x3,y3) lies
-// in the segment joining (x1,y1) and (x2,y2), -1 if it lies on one side, and 1 if on the other.
-int checkPointWRTSegment(float x1, float y1, float x2, float y2, float x3, float y3)
+// det3(x1, y1, 1.0, x2, y2, 1.0, x3, y3, 1.0) of four lanes, with the terms summed in the same
+// order as geometry::det3.
+static inline __m128 orientation(__m128 x1, __m128 y1, __m128 x2, __m128 y2, __m128 x3, __m128 y3)
 {
-   if (x1 < x2)
-   {
-      if (x3 < x1) return -1;
-	  else if (x3 > x2) return 1;
-	  else return 0;
-   }
-   else if (x2 < x1)
-   {
-      if (x3 < x2) return -1;
-	  else if (x3 > x1) return 1;
-	  else return 0;
-   }
-   else // x1 = x2
-   {
-	  if (y1 < y2)
-	  {
-         if (y3 < y1) return -1;
-	     else if (y3 > y2) return 1;
-	     else return 0;
-	  }
-	  else // x1 = x2 & y2 < = y1
-	  {
-         if (y3 < y2) return -1;
-	     else if (y3 > y1) return 1;
-	     else return 0;
-	  }
-   }
+   __m128 d = _mm_sub_ps(_mm_mul_ps(x1, y2), _mm_mul_ps(x1, y3));
+   d = _mm_add_ps(d, _mm_mul_ps(y1, x3));
+   d = _mm_sub_ps(d, _mm_mul_ps(y1, x2));
+   d = _mm_add_ps(d, _mm_mul_ps(x2, y3));
+   return _mm_sub_ps(d, _mm_mul_ps(y2, x3));
 }
 
-// Return 1 if the segment joining (x1,y1) and (x2,y2) intersects the 
-// segment joining (x3,y3) and (x4,y4), otherwise return 0.
-int checkSegmentsIntersection(float x1, float y1, float x2, float y2, 
-							 float x3, float y3, float x4, float y4)
+// Mask of the lanes in which the segment joining (x1,y1) and (x2,y2) intersects the segment
+// joining (x3,y3) and (x4,y4), from where the straight lines through them cross: the unique
+// crossing, parallel and collinear cases are all evaluated and the one that applies is
+// selected per lane.
+static inline __m128 segmentsIntersection(__m128 x1, __m128 y1, __m128 x2, __m128 y2,
+   __m128 x3, __m128 y3, __m128 x4, __m128 y4)
 {
-   float denom, p, q;	 
-   denom = det2(x2 - x1, x3 - x4, y2 - y1, y3 - y4);
-
-   if (denom != 0) 
-   // The straight lines through (x1,y1) and (x2,y2) and through (x3,y3) and (x4,y4) 
-   // intersect uniquely at (1-p)(x1,y1) + p(x2,y2) = (1-q)(x3,y3) + q(x4,y4), which
-   // is a point of both segments if both p and q are between 0 and 1.
-   {
-      p = det2(x3 - x1, x3 - x4, y3 - y1, y3 - y4) / denom;
-      q = det2(x2 - x1, x3 - x1, y2 - y1, y3 - y1) / denom;
-	  if ( (p >= 0) && (p <= 1) && (q >= 0) && (q <= 1) ) return 1;
-	  else return 0;
-   }
-
-   else if ( det2(x3 - x2, x3 - x1, y3 - y2, y3 - y1) != 0 ) 
-   // The straight lines through (x1,y1) and (x2,y2) and through (x3,y3) and (x4,y4) 
-   // do no intersect uniquely, and (x1,y1), (x2,y2) and (x3,y3) are not collinear,
-   // in which case the segments do not intersect.	   
-      return 0; 
+   const __m128 zero = _mm_setzero_ps();
+   const __m128 one = _mm_set1_ps(1.0f);
+
+   // Lines intersect uniquely: both parameters must lie in [0,1].
+   __m128 denom = det2(_mm_sub_ps(x2, x1), _mm_sub_ps(x3, x4), _mm_sub_ps(y2, y1), _mm_sub_ps(y3, y4));
+   __m128 p = _mm_div_ps(det2(_mm_sub_ps(x3, x1), _mm_sub_ps(x3, x4), _mm_sub_ps(y3, y1), _mm_sub_ps(y3, y4)), denom);
+   __m128 q = _mm_div_ps(det2(_mm_sub_ps(x2, x1), _mm_sub_ps(x3, x1), _mm_sub_ps(y2, y1), _mm_sub_ps(y3, y1)), denom);
+   __m128 crossing = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(p, zero), _mm_cmple_ps(p, one)),
+      _mm_and_ps(_mm_cmpge_ps(q, zero), _mm_cmple_ps(q, one)));
+
+   // Parallel lines: only collinear segments can intersect.
+   __m128 collinear = _mm_cmpeq_ps(det2(_mm_sub_ps(x3, x2), _mm_sub_ps(x3, x1), _mm_sub_ps(y3, y2), _mm_sub_ps(y3, y1)), zero);
+
+   // Collinear segments: as geometry::checkPointWRTSegment, compare along x unless the first segment is
+   // vertical, and intersect unless (x3,y3) and (x4,y4) are beyond the same end.
+   __m128 alongX = _mm_cmpneq_ps(x1, x2);
+   __m128 a1 = select(alongX, x1, y1), a2 = select(alongX, x2, y2);
+   __m128 a3 = select(alongX, x3, y3), a4 = select(alongX, x4, y4);
+   __m128 low = _mm_min_ps(a1, a2), high = _mm_max_ps(a1, a2);
+   __m128 apart = _mm_or_ps(_mm_and_ps(_mm_cmpgt_ps(a3, high), _mm_cmpgt_ps(a4, high)),
+      _mm_and_ps(_mm_cmplt_ps(a3, low), _mm_cmplt_ps(a4, low)));
+   __m128 overlapping = _mm_andnot_ps(apart, collinear);
+
+   return select(_mm_cmpneq_ps(denom, zero), crossing, overlapping);
+}
 
-   else
-   // All four points are collinear, in which case they do not intersect if 
-   // (x3,y3) and (x4,y4) both lie on the same side of segment joining (x1,y1) and (x2,y2). 
-   {
-	  if ( 
-		    (  (checkPointWRTSegment(x1, y1, x2, y2, x3, y3) == 1) && 
-		       (checkPointWRTSegment(x1, y1, x2, y2, x4, y4) == 1)
-		    )
-		    ||
-            (  (checkPointWRTSegment(x1, y1, x2, y2, x3, y3) == -1) && 
-		       (checkPointWRTSegment(x1, y1, x2, y2, x4, y4) == -1)
-		    )
-		 )
-         return 0;
-	  else return 1;
-   }
+// Mask of the lanes in which the point (x5,y5) lies in the quadrilateral with vertices at
+// (x1,y1), (x2,y2), (x3,y3) and (x4,y4), as geometry::checkPointInQuadrilateral but in plain float.
+static inline __m128 pointInQuadrilateral(__m128 x1, __m128 y1, __m128 x2, __m128 y2,
+   __m128 x3, __m128 y3, __m128 x4, __m128 y4, __m128 x5, __m128 y5)
+{
+   const __m128 zero = _mm_setzero_ps();
+   __m128 d1 = orientation(x1, y1, x2, y2, x5, y5);
+   __m128 d2 = orientation(x2, y2, x3, y3, x5, y5);
+   __m128 d3 = orientation(x3, y3, x4, y4, x5, y5);
+   __m128 d4 = orientation(x4, y4, x1, y1, x5, y5);
+   __m128 counterClockwise = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(d1, zero), _mm_cmpge_ps(d2, zero)),
+      _mm_and_ps(_mm_cmpge_ps(d3, zero), _mm_cmpge_ps(d4, zero)));
+   __m128 clockwise = _mm_and_ps(_mm_and_ps(_mm_cmple_ps(d1, zero), _mm_cmple_ps(d2, zero)),
+      _mm_and_ps(_mm_cmple_ps(d3, zero), _mm_cmple_ps(d4, zero)));
+   return _mm_or_ps(counterClockwise, clockwise);
 }
 
-// Return 1 if the point (x5,y5) lies in the quadrilateral with vertices at (x1,y1), (x2,y2), (x3,y3) 
-// and (x4,y4), otherwise return 0.
-int checkPointInQuadrilateral(float x1, float y1, float x2, float y2, float x3, float y3, float x4, float y4,
-							   float x5, float y5)
+// Set the bits of the four results for primitives i to i + 3 in mask.
+static inline void storeMask(__m128 result, int i, unsigned int* mask)
 {
-   // Point (x5,y5) lies in the quadrilateral with vertices at (x1,y1), (x2,y2), (x3,y3) and (x4,y4)
-   // if the orders (xi,yi,1), (x(i+1),y(i+1),1), (x5,y5) all appear clockwise or all counter-clockwise.
-   if (
-		 (  (det3(x1, y1, 1.0, x2, y2, 1.0, x5, y5, 1.0) >= 0) &&
-	        (det3(x2, y2, 1.0, x3, y3, 1.0, x5, y5, 1.0) >= 0) &&
-		    (det3(x3, y3, 1.0, x4, y4, 1.0, x5, y5, 1.0) >= 0) &&
-		    (det3(x4, y4, 1.0, x1, y1, 1.0, x5, y5, 1.0) >= 0) 
-         )
-	     ||
-	     (  (det3(x1, y1, 1.0, x2, y2, 1.0, x5, y5, 1.0) <= 0) &&
-	        (det3(x2, y2, 1.0, x3, y3, 1.0, x5, y5, 1.0) <= 0) &&
-    	    (det3(x3, y3, 1.0, x4, y4, 1.0, x5, y5, 1.0) <= 0) &&
- 		    (det3(x4, y4, 1.0, x1, y1, 1.0, x5, y5, 1.0) <= 0)
-         )
-      )
-	  return 1;
-   else  return 0;
+   if (i % 32 == 0) mask[i / 32] = 0;
+   mask[i / 32] |= (unsigned int)_mm_movemask_ps(result) << (i % 32);
 }
 
-// Return 1 if the quadrilateral with  vertices (x1,y1), (x2,y2), (x3,y3) and (x4,y4) 
-// intersects the quadrilateral with vertices at (x5,y5), (x6,y6), (x7,y7) and (x8,y8) 
-// (both assumed not self-intersecting), otherwise return 0.
-int checkQuadrilateralsIntersection(float x1, float y1, float x2, float y2, 
-								    float x3, float y3, float x4, float y4,
-								    float x5, float y5, float x6, float y6, 
-								    float x7, float y7, float x8, float y8)
+// Set or clear bit i of mask.
+static inline void storeBit(int result, int i, unsigned int* mask)
 {
-   // The boundaries of the two quadrilaterals intersect if one of the 16 pairs of sides,
-   // one from either quadrilateral, is intersecting.
-   if ( checkSegmentsIntersection(x1, y1, x2, y2, x5, y5, x6, y6) ||
-	    checkSegmentsIntersection(x1, y1, x2, y2, x6, y6, x7, y7) ||
-		checkSegmentsIntersection(x1, y1, x2, y2, x7, y7, x8, y8) ||
-	    checkSegmentsIntersection(x1, y1, x2, y2, x8, y8, x5, y5) ||
-        checkSegmentsIntersection(x2, y2, x3, y3, x5, y5, x6, y6) ||
-	    checkSegmentsIntersection(x2, y2, x3, y3, x6, y6, x7, y7) ||
-		checkSegmentsIntersection(x2, y2, x3, y3, x7, y7, x8, y8) ||
-	    checkSegmentsIntersection(x2, y2, x3, y3, x8, y8, x5, y5) ||
-		checkSegmentsIntersection(x3, y3, x4, y4, x5, y5, x6, y6) ||
-	    checkSegmentsIntersection(x3, y3, x4, y4, x6, y6, x7, y7) ||
-		checkSegmentsIntersection(x3, y3, x4, y4, x7, y7, x8, y8) ||
-	    checkSegmentsIntersection(x3, y3, x4, y4, x8, y8, x5, y5) ||
-		checkSegmentsIntersection(x4, y4, x1, y1, x5, y5, x6, y6) ||
-	    checkSegmentsIntersection(x4, y4, x1, y1, x6, y6, x7, y7) ||
-		checkSegmentsIntersection(x4, y4, x1, y1, x7, y7, x8, y8) ||
-	    checkSegmentsIntersection(x4, y4, x1, y1, x8, y8, x5, y5) 
-	  )
-	   return 1;
-
-   // If the boundaries do not intersect then the quadrilaterals intersect when one
-   // lies entirely within the other, which is checked by examining if the vertex (x5,y5)
-   // lies in the first quadrilateral, which would imply (given that the boundaries don't
-   // intersect) that the second quadrilateral lies entirely within the first, or if the  
-   // vertex (x1,y1) lies in the second quadrilateral, which would imply that the first 
-   // quadrilateral lies entirely in the second.
-   else if ( checkPointInQuadrilateral(x1, y1, x2, y2, x3, y3, x4, y4, x5, y5) ) return 1;
-   else if ( checkPointInQuadrilateral(x5, y5, x6, y6, x7, y7, x8, y8, x1, y1) ) return 1;
-
-   else return 0;
+   if (i % 32 == 0) mask[i / 32] = 0;
+   if (result) mask[i / 32] |= 1u << (i % 32);
 }
 
-// Return 1 if the axes-parallel rectangle with diagonally opposite corners at (x1,y1) and (x2,y2)
-// intersects the disc centered (x3,y3) of radius r, otherwise return 0.
-int checkDiscRectangleIntersection(float x1, float y1, float x2, float y2, float x3, float y3, float r)
+// Set bit i if the axes-parallel rectangle with diagonally opposite corners at (x1,y1) and (x2,y2)
+// intersects the disc centered (x3[i],y3[i]) of radius r[i].
+void checkDiscsRectangleIntersection(float x1, float y1, float x2, float y2,
+   const float* x3, const float* y3, const float* r, int n, unsigned int* mask)
 {
-   float minX, maxX, minY, maxY;
+   __m128 minX = _mm_set1_ps(x1 <= x2 ? x1 : x2), maxX = _mm_set1_ps(x1 <= x2 ? x2 : x1);
+   __m128 minY = _mm_set1_ps(y1 <= y2 ? y1 : y2), maxY = _mm_set1_ps(y1 <= y2 ? y2 : y1);
+   __m128 cornerX1 = _mm_set1_ps(x1), cornerY1 = _mm_set1_ps(y1);
+   __m128 cornerX2 = _mm_set1_ps(x2), cornerY2 = _mm_set1_ps(y2);
 
-   // Set minX to smaller of x1 and x2, and maxX to the larger; likewise minY and maxY.
-   if (x1 <= x2) 
-   {
-      minX = x1; maxX = x2;
-   }
-   else
+   int i = 0;
+   for (; i + 4 <= n; i += 4)
    {
-      minX = x2; maxX = x1;
-   }
-   if (y1 <= y2) 
-   {
-      minY = y1; maxY = y2;
-   }
-   else
-   {
-      minY = y2; maxY = y1;
+      __m128 cx = _mm_loadu_ps(x3 + i), cy = _mm_loadu_ps(y3 + i), radius = _mm_loadu_ps(r + i);
+      __m128 radiusSquared = _mm_mul_ps(radius, radius);
+
+      // Center in the rectangle grown by r horizontally or vertically.
+      __m128 inX = _mm_and_ps(_mm_cmpge_ps(cx, minX), _mm_cmple_ps(cx, maxX));
+      __m128 inY = _mm_and_ps(_mm_cmpge_ps(cy, minY), _mm_cmple_ps(cy, maxY));
+      __m128 inGrownX = _mm_and_ps(_mm_cmpge_ps(cx, _mm_sub_ps(minX, radius)), _mm_cmple_ps(cx, _mm_add_ps(maxX, radius)));
+      __m128 inGrownY = _mm_and_ps(_mm_cmpge_ps(cy, _mm_sub_ps(minY, radius)), _mm_cmple_ps(cy, _mm_add_ps(maxY, radius)));
+      __m128 hit = _mm_or_ps(_mm_and_ps(inGrownX, inY), _mm_and_ps(inX, inGrownY));
+
+      // Center within r of a corner.
+      __m128 dx1 = _mm_sub_ps(cx, cornerX1), dx2 = _mm_sub_ps(cx, cornerX2);
+      __m128 dy1 = _mm_sub_ps(cy, cornerY1), dy2 = _mm_sub_ps(cy, cornerY2);
+      dx1 = _mm_mul_ps(dx1, dx1); dx2 = _mm_mul_ps(dx2, dx2);
+      dy1 = _mm_mul_ps(dy1, dy1); dy2 = _mm_mul_ps(dy2, dy2);
+      hit = _mm_or_ps(hit, _mm_cmple_ps(_mm_add_ps(dx1, dy1), radiusSquared));
+      hit = _mm_or_ps(hit, _mm_cmple_ps(_mm_add_ps(dx1, dy2), radiusSquared));
+      hit = _mm_or_ps(hit, _mm_cmple_ps(_mm_add_ps(dx2, dy2), radiusSquared));
+      hit = _mm_or_ps(hit, _mm_cmple_ps(_mm_add_ps(dx2, dy1), radiusSquared));
+
+      storeMask(hit, i, mask);
    }
 
-   // The disc intersects the rectangle if its center lies in the strip with corners at
-   // (minX-r, minY) and (maxX+r, maxY), or if its center lies in the strip with corners
-   // at (minX, minY-r) and (maxX, maxY+r), or if its center is within distance r of one
-   // the four corners of the rectangles.
-   if      ( (x3 >= minX - r) && (x3 <= maxX + r) && (y3 >= minY) && (y3 <= maxY) ) return 1;
-   else if ( (x3 >= minX) && (x3 <= maxX) && (y3 >= minY - r) && (y3 <= maxY + r) ) return 1;
-   else if ( (x3 - x1)*(x3-x1) + (y3 - y1)*(y3 - y1) <= r*r ) return 1;
-   else if ( (x3 - x1)*(x3-x1) + (y3 - y2)*(y3 - y2) <= r*r ) return 1;
-   else if ( (x3 - x2)*(x3-x2) + (y3 - y2)*(y3 - y2) <= r*r ) return 1;
-   else if ( (x3 - x2)*(x3-x2) + (y3 - y1)*(y3 - y1) <= r*r ) return 1;
-   else return 0;
+   for (; i < n; i++)
+      storeBit(geometry::checkDiscRectangleIntersection(x1, y1, x2, y2, x3[i], y3[i], r[i]), i, mask);
 }
 
+// Set bit i if the quadrilateral with vertices (x1,y1), (x2,y2), (x3,y3) and (x4,y4) intersects
+// quadrilateral i of quads.
+void checkQuadrilateralsIntersection(float x1, float y1, float x2, float y2,
+   float x3, float y3, float x4, float y4, const QuadrilateralArrays& quads, int n, unsigned int* mask)
+{
+   __m128 ax[4] = { _mm_set1_ps(x1), _mm_set1_ps(x2), _mm_set1_ps(x3), _mm_set1_ps(x4) };
+   __m128 ay[4] = { _mm_set1_ps(y1), _mm_set1_ps(y2), _mm_set1_ps(y3), _mm_set1_ps(y4) };
+
+   int i = 0;
+   for (; i + 4 <= n; i += 4)
+   {
+      __m128 bx[4], by[4];
+      for (int k = 0; k < 4; k++)
+      {
+         bx[k] = _mm_loadu_ps(quads.x[k] + i);
+         by[k] = _mm_loadu_ps(quads.y[k] + i);
+      }
+
+      // Any of the 16 pairs of sides intersecting, or either quadrilateral containing a
+      // vertex of the other.
+      __m128 hit = _mm_setzero_ps();
+      for (int a = 0; a < 4; a++)
+         for (int b = 0; b < 4; b++)
+            hit = _mm_or_ps(hit, segmentsIntersection(ax[a], ay[a], ax[(a + 1) % 4], ay[(a + 1) % 4],
+               bx[b], by[b], bx[(b + 1) % 4], by[(b + 1) % 4]));
+      hit = _mm_or_ps(hit, pointInQuadrilateral(ax[0], ay[0], ax[1], ay[1], ax[2], ay[2], ax[3], ay[3], bx[0], by[0]));
+      hit = _mm_or_ps(hit, pointInQuadrilateral(bx[0], by[0], bx[1], by[1], bx[2], by[2], bx[3], by[3], ax[0], ay[0]));
+
+      storeMask(hit, i, mask);
+   }
 
+   for (; i < n; i++)
+      storeBit(geometry::checkGeneralQuadrilateralsIntersection(x1, y1, x2, y2, x3, y3, x4, y4,
+         quads.x[0][i], quads.y[0][i], quads.x[1][i], quads.y[1][i],
+         quads.x[2][i], quads.y[2][i], quads.x[3][i], quads.y[3][i]), i, mask);
+}
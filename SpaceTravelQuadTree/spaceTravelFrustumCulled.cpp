@@ -5,116 +5,107 @@
 // It draws a conical spacecraft that can travel and an array of fixed spherical 
 // asteroids. The view in the left viewport is from a fixed camera; the view in 
 // the right viewport is from the spacecraft.There is approximate collision detection.  
-// Frustum culling is implemented by means of a quadtree data structure.
+// Frustum culling is implemented by means of a bounding volume hierarchy.
 // 
 // COMPILE NOTE: File intersectionDetectionRoutines.cpp must be in the same folder.
-// EXECUTION NOTE: If ROWS and COLUMNS are large the quadtree takes time to build so
+// EXECUTION NOTE: If ROWS and COLUMNS are large the hierarchy takes time to build so
 //                 the display may take several seconds to come up.
 //
 // User-defined constants: 
 // ROWS is the number of rows of  asteroids.
 // COLUMNS is the number of columns of asteroids.
 // FILL_PROBABILITY is the percentage probability that a particular row-column slot
-// will be filled with an asteroid.
+// will be filled with an asteroid. It and the other asteroid parameters may be overridden
+// in field.cfg, which is reloaded along with the shaders whenever it is saved.
 //
 // Interaction:
 // Press the left/right arrow keys to turn the craft.
 // Press the up/down arrow keys to move the craft.
 // Press space to toggle between frustum culling enabled and disabled.
+// Press O to toggle occlusion culling, which works along with frustum culling.
+// Press G to toggle the quality governor, which lowers the quality while frames are slow.
 // 
 // Sumanta Guha.
 ////////////////////////////////////////////////////////////////////////////////////// 
 #include <ctime> 
+#include <algorithm>
+#include <chrono>
 #include <cmath>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
 
 #include "intersectionDetectionRoutines.h"
+#include "AssetReloader.h"
+#include "AsteroidField.h"
+#include "CraftSystem.h"
+#include "Benchmarks.h"
+#include "Profiler.h"
+#include "QualityGovernor.h"
 #include "Asteroid.h"
 #include "Renderer.h"
 #include "Input.h"
+#include "TaskGraph.h"
 
 using namespace std;
 
 // Globals.
-static float angle = 0.0; // Angle of the spacecraft.
-static float xVal = 0, zVal = 0; // Co-ordinates of the spacecraft.
 static int isFrustumCulled = 0;
-static int isCollision = 0; // Is there collision between the spacecraft and an asteroid?
-static float speed, angSpeed;
-static float tempxVal, tempzVal, tempAngle;
+static int isOcclusionCulled = 0;
 
+#define PLAYER_CRAFT 0 // Index of the spacecraft flown with the keyboard.
 
-// the asteroids and quad tree from the initial program
-Asteroid **arrayAsteroids; // Global array of asteroids.
 
-// Initialization routine.
+// Initialization routine. The window and everything that needs its OpenGL context are made on
+// the main thread while the meshes and the asteroid field, with its spatial indexes, are built
+// on other threads.
 void setup(void)
 {
 	Renderer& renderer = Renderer::getInstance();
-
-	int i, j;
-	// create meory for each potential asteroid
-	arrayAsteroids = new Asteroid *[ROWS];
-	for (int i = 0; i < ROWS; i++) {
-		arrayAsteroids[i] = new Asteroid[COLUMNS];
-	}
-
-	renderer.createLine();
-
-	renderer.createCone();
-
-	renderer.createSphere();
-
-	// Initialize global arrayAsteroids.
-	for (j = 0; j < COLUMNS; j++)
-		for (i = 0; i < ROWS; i++)
-			if (rand() % 100 < FILL_PROBABILITY)
-				// If rand()%100 >= FILL_PROBABILITY the default constructor asteroid remains in the slot which
-				// indicates that there is no asteroid there because the default's radius is 0.
-			{
-				// Position the asteroids depending on if there is an even or odd number of columns
-				// so that the spacecraft faces the middle of the asteroid field.
-				int oddevenOffset = (COLUMNS % 2) ? 0.0 : 15.0;
-
-				arrayAsteroids[i][j] = Asteroid(oddevenOffset + 30.0*(-COLUMNS / 2 + j), 0.0, -40.0 - 30.0*i, 3.0,
-					rand() % 256, rand() % 256, rand() % 256);
-			}
-
-	renderer.createBuffers();
-}
-
-// Function to check if two spheres centered at (x1,y1,z1) and (x2,y2,z2) with
-// radius r1 and r2 intersect.
-int checkSpheresIntersection(float x1, float y1, float z1, float r1,
-	float x2, float y2, float z2, float r2)
-{
-	return ((x1 - x2)*(x1 - x2) + (y1 - y2)*(y1 - y2) + (z1 - z2)*(z1 - z2) <= (r1 + r2)*(r1 + r2));
-}
-
-// Function to check if the spacecraft collides with an asteroid when the center of the base
-// of the craft is at (x, 0, z) and it is aligned at an angle a to to the -z direction.
-// Collision detection is approximate as instead of the spacecraft we use a bounding sphere.
-int asteroidCraftCollision(float x, float z, float a)
-{
-	int i, j;
-
-	// Check for collision with each asteroid.
-	for (j = 0; j < COLUMNS; j++)
-		for (i = 0; i < ROWS; i++)
-			if (arrayAsteroids[i][j].getRadius() > 0) // If asteroid exists.
-				if (checkSpheresIntersection(x - 5 * sin((PI / 180.0) * a), 0.0,
-					z - 5 * cos((PI / 180.0) * a), 7.072,
-					arrayAsteroids[i][j].getCenterX(), arrayAsteroids[i][j].getCenterY(),
-					arrayAsteroids[i][j].getCenterZ(), arrayAsteroids[i][j].getRadius()))
-					return 1;
-	return 0;
+	TaskGraph startup;
+
+	int window = startup.add("window and context", [&renderer]() {
+		if (renderer.start() != 0) exit(EXIT_FAILURE);
+	}, {}, true);
+
+	startup.add("input", []() {
+		Input::getInstance().start();
+	}, { window }, true);
+
+	int meshes = startup.add("meshes", [&renderer]() {
+		renderer.createMeshes();
+	});
+
+	startup.add("buffers and shaders", [&renderer]() {
+		renderer.createBuffers();
+	}, { window, meshes }, true);
+
+	// Initialize the asteroid field, with the defaults if there is no valid config file.
+	// Other threads do not share the main thread's random sequence on every platform, so
+	// the field gets its seed explicitly.
+	unsigned int seed = (unsigned int)time(0);
+	int field = startup.add("asteroid field", [seed]() {
+		FieldConfig config;
+		if (!AsteroidField::loadConfig(FIELD_CONFIG_FILE, config)) config = FieldConfig();
+		if (config.seed == 0) config.seed = seed;
+		AsteroidField::getInstance().generate(config);
+	});
+
+	// The player's spacecraft starts at the origin.
+	startup.add("crafts", []() {
+		CraftSystem::getInstance().add(0.0, 0.0, 0.0);
+	}, { field });
+
+	startup.run();
+	startup.report(cout);
 }
 
 void update()
 {
 	Input& input = Input::getInstance();
+	CraftSystem& crafts = CraftSystem::getInstance();
 
-	speed = angSpeed = 0;
+	float speed = 0, angSpeed = 0;
 
 	if (input.getKey(KEYCODE_DOWN))
 	{
@@ -136,71 +127,118 @@ void update()
 		angSpeed -= 1;
 	}
 
-	tempAngle = angle + angSpeed * 2.0;
-
-	// Angle correction.
-	if (tempAngle > 360.0) tempAngle -= 360.0;
-	if (tempAngle < 0.0) tempAngle += 360.0;
-
-	tempxVal = xVal + speed * sin(tempAngle * PI / 180.0);
-	tempzVal = zVal + speed * cos(tempAngle * PI / 180.0);
+	if (input.getKeyDown(KEYCODE_SPACE))
+	{
+		isFrustumCulled = !isFrustumCulled;
+	}
 
-	// Move spacecraft to next position only if there will not be collision with an asteroid.
-	if (!asteroidCraftCollision(tempxVal, tempzVal, tempAngle))
+	if (input.getKeyDown(KEYCODE_O))
 	{
-		isCollision = 0;
-		xVal = tempxVal;
-		zVal = tempzVal;
-		angle = tempAngle;
+		isOcclusionCulled = !isOcclusionCulled;
+		Renderer::getInstance().getScene().setOcclusionCulled(isOcclusionCulled != 0);
 	}
-	else
+
+	if (input.getKeyDown(KEYCODE_G))
 	{
-		tempxVal = xVal;
-		tempzVal = zVal;
-		tempAngle = angle;
-		isCollision = 1;
+		QualityGovernor& governor = QualityGovernor::getInstance();
+		governor.setEnabled(!governor.isEnabled());
+		Renderer::getInstance().getScene().setQuality(governor.getQuality());
+		cout << "Quality governor " << (governor.isEnabled() ? "on" : "off") << endl;
 	}
+
+	// Asteroids move first, then the crafts collide against their new positions.
+	AsteroidField::getInstance().step(1.0);
+
+	crafts.setInput(PLAYER_CRAFT, speed, angSpeed);
+	crafts.update();
 }
 
 // Routine to output interaction instructions to the C++ window.
 void printInteraction(void)
 {
-	cout << "ALERT: The OpenGL window may take a while to come up because" << endl
-		<< "of the time to build the quadtree!" << endl
+	cout << "ALERT: The asteroids may take a while to come up because" << endl
+		<< "of the time to build the bounding volume hierarchy!" << endl
 		<< endl;
 	cout << "Interaction:" << endl;
 	cout << "Press the left/right arrow keys to turn the craft." << endl
 		<< "Press the up/down arrow keys to move the craft." << endl
-		<< "Press space to toggle between frustum culling enabled and disabled." << endl;
+		<< "Press space to toggle between frustum culling enabled and disabled." << endl
+		<< "Press O to toggle occlusion culling, which works along with frustum culling." << endl
+		<< "Press G to toggle the quality governor, which lowers the quality while frames are slow." << endl
+		<< "Save " << VERTEX_SHADER_FILE << ", " << FRAGMENT_SHADER_FILE << " or " << FIELD_CONFIG_FILE
+		<< " to reload it." << endl;
 }
 
 // Main routine.
 int main(int argc, char **argv)
 {
-
+	// Headless benchmarks.
+	if (argc > 1 && strcmp(argv[1], "--bench-crafts") == 0) return runCraftBenchmark();
+	if (argc > 1 && strcmp(argv[1], "--bench-rays") == 0) return runRayBenchmark();
+	if (argc > 1 && strcmp(argv[1], "--bench-quads") == 0) return runQuadBenchmark();
+	if (argc > 1 && strcmp(argv[1], "--check-shader-cache") == 0) return runShaderCacheCheck();
+	if (argc > 1 && strcmp(argv[1], "--check-intersections") == 0) return runIntersectionCheck();
+	if (argc > 1 && strcmp(argv[1], "--render-software") == 0) return runSoftwareRenderBenchmark();
+	if (argc > 1 && strcmp(argv[1], "--bench-submit") == 0) return runSubmitBenchmark();
+	if (argc > 1 && strcmp(argv[1], "--bench-packing") == 0) return runPackingBenchmark();
+	if (argc > 1 && strcmp(argv[1], "--bench-governor") == 0) return runGovernorBenchmark();
+
+	chrono::steady_clock::time_point launch = chrono::steady_clock::now();
 	srand((unsigned)time(0));
 	printInteraction();
 
 	Renderer& renderer = Renderer::getInstance();
 	Input& input = Input::getInstance();
 
-	renderer.start();
-	input.start();
-
 	// init the graphics and rest of the app
 	setup();
 
+	QualityGovernor& governor = QualityGovernor::getInstance();
+	AssetReloader& reloader = AssetReloader::getInstance();
+	reloader.start(renderer.getWindow(), VERTEX_SHADER_FILE, FRAGMENT_SHADER_FILE, FIELD_CONFIG_FILE);
+
 	// run!
+	bool firstFrame = true;
 	while (!renderer.isDisposed())
 	{
+		// Edited assets only change between frames.
+		bool isReloaded = reloader.apply();
+
+		// While no key is used, the field stands still and the window still shows the last frame,
+		// nothing would change: wait for something to happen instead of simulating and drawing.
+		bool isRedrawNeeded = renderer.takeRedraw();
+		if (!isReloaded && !isRedrawNeeded && input.isIdle() && !AsteroidField::getInstance().isMoving())
+		{
+			// The wait is no part of the frame times.
+			renderer.waitEvents();
+			governor.reset();
+			continue;
+		}
+
+		chrono::steady_clock::time_point frameStart = chrono::steady_clock::now();
 		update();
 
 		// Flush the InputManager at the end of every frame
 		input.flush();
 
-		renderer.draw(arrayAsteroids, xVal, zVal, angle);
+		CraftSystem& crafts = CraftSystem::getInstance();
+		renderer.draw(AsteroidField::getInstance(),
+			crafts.getX(PLAYER_CRAFT), crafts.getZ(PLAYER_CRAFT), crafts.getAngle(PLAYER_CRAFT), isFrustumCulled != 0);
+
+		if (governor.addFrame(chrono::duration<double, milli>(chrono::steady_clock::now() - frameStart).count()))
+			renderer.getScene().setQuality(governor.getQuality());
+
+		Profiler::getInstance().endFrame();
+
+		if (firstFrame)
+		{
+			cout << "First frame after " << chrono::duration<double, milli>(chrono::steady_clock::now() - launch).count()
+				<< " ms" << endl;
+			firstFrame = false;
+		}
 	}
 
+	reloader.stop();
 
 	return 0;
 
@@ -1,7 +1,29 @@
 #version 120
+// Vertex of the mesh, stored over its largest coordinate when meshScale is not 1.
 in vec4 vPosition;
+uniform float meshScale;
+
+// Instance: where the mesh is moved to from instanceOrigin and its turn about y in degrees, and
+// its color. Constant when the modelview matrix places the mesh instead.
+in vec4 iPosition;
+in vec4 iColor;
+uniform vec3 instanceOrigin;
+
+// Set for impostors: the mesh is a quad in the xy plane, which is turned to face the camera.
+uniform float impostor;
+varying vec2 impostorCorner;
+
 void main()
 {
-    gl_Position    = gl_ModelViewProjectionMatrix * vPosition;
-    gl_FrontColor  = gl_Color;
-}
\ No newline at end of file
+    vec3 p = vPosition.xyz * meshScale;
+    float c = cos(radians(iPosition.w)), s = sin(radians(iPosition.w));
+    p = vec3(c * p.x + s * p.z, p.y, c * p.z - s * p.x) + instanceOrigin + iPosition.xyz;
+    gl_Position    = gl_ModelViewProjectionMatrix * vec4(p, 1.0);
+    if (impostor > 0.5)
+    {
+        vec4 center = gl_ModelViewMatrix * vec4(instanceOrigin + iPosition.xyz, 1.0);
+        gl_Position = gl_ProjectionMatrix * (center + vec4(vPosition.xy * meshScale, 0.0, 0.0));
+        impostorCorner = sign(vPosition.xy);
+    }
+    gl_FrontColor  = iColor;
+}